@@ -18,9 +18,14 @@
 
 #include "HTL_onboard.h"
 
+#define TASK_FREE 0
+#define TASK_WAITING 1 // In the timer wheel
+#define TASK_READY 2 // Due, waiting for a gap between the slots
+#define TASK_RUNNING 3
+
 // Segment mapping for hexadecimal digits (0-9, A-F)
-// Bit order: abcdefg (g is the LSB)
-const uint8_t segmentMap[16] = {
+// Bit order: abcdefg (g is the LSB), kept in flash and read with pgm_read_byte()
+static const uint8_t segmentMap[16] PROGMEM = {
     0b01111110,  // 0
     0b00110000,  // 1
     0b01101101,  // 2
@@ -41,8 +46,8 @@ const uint8_t segmentMap[16] = {
 
 
 // Segment mapping for hexadecimal digits (0-9, A-F) and some characters
-// Bit order: abcdefg (g is the LSB)
-const uint8_t charMap[128] = {
+// Bit order: abcdefg (g is the LSB), kept in flash and read with pgm_read_byte()
+static const uint8_t charMap[128] PROGMEM = {
     // First 32 characters are unsupported
     0b00000000,
     0b00000000,
@@ -177,9 +182,132 @@ const uint8_t charMap[128] = {
 };
 
 
-HTL_onboard::HTL_onboard() {}
+// Converts a segment value (abcdefg, g is the LSB) and the sign/tens flags into data lines of pinMapping
+static uint16_t hexLines(uint8_t segments, bool negative, bool tens) {
+    uint16_t lines = 0;
+
+    for (int i = 0; i < 7; i++) {
+        if (segments & (1 << (6 - i))) {
+            lines |= (1 << i);
+        }
+    }
+
+    if (negative) {
+        lines |= (1 << 7);
+    }
+
+    if (tens) {
+        lines |= (1 << 8) | (1 << 9);
+    }
+
+    return lines;
+}
+
+#if HTL_PAGED_NUMBERS
+// Pages of a paged number, most significant digit first. Bit 7 of a page lights the minus line.
+// A blank page separates equal digits and two blank pages end the number, so 11 and 1111 differ.
+// A single digit is one page.
+static uint8_t encodePages(uint8_t* pages, bool negative, uint16_t magnitude, uint8_t base) {
+    uint8_t minus = negative ? 0x80 : 0;
+    uint8_t digits[5];
+    uint8_t count = 0;
+    do {
+        digits[count++] = magnitude % base;
+        magnitude /= base;
+    } while (magnitude);
+
+    if (count == 1) {
+        pages[0] = minus | pgm_read_byte(&segmentMap[digits[0]]);
+        return 1;
+    }
+
+    uint8_t length = 0;
+    for (uint8_t i = count; i-- > 0;) {
+        if (i + 1 < count && digits[i] == digits[i + 1]) {
+            pages[length++] = minus;
+        }
+        pages[length++] = minus | pgm_read_byte(&segmentMap[digits[i]]);
+    }
+    pages[length++] = 0;
+    pages[length++] = 0;
+    return length;
+}
+#endif
+
+// Returns the segments of a character, falling back to the other letter case and then to '0'
+static uint8_t charSegments(char c) {
+    if (c == ' ') {
+        return 0;
+    }
+
+    // Every character is looked up in flash once, only unsupported ones try the other case
+    uint8_t segments = (c >= 32 && c <= 127) ? pgm_read_byte(&charMap[(uint8_t)c]) : 0;
+    if (segments == 0) {
+        // Check if the character has an uppercase or lowercase equivalent in the charMap
+        if (c >= 'a' && c <= 'z') {
+            segments = pgm_read_byte(&charMap[(uint8_t)(c - 'a' + 'A')]);
+        } else if (c >= 'A' && c <= 'Z') {
+            segments = pgm_read_byte(&charMap[(uint8_t)(c - 'A' + 'a')]);
+        }
+
+        // If still unsupported, default to '0'
+        if (segments == 0) {
+            segments = pgm_read_byte(&charMap['0']);
+        }
+    }
+
+    return segments;
+}
+
+// Data lines of one bit plane of a color. The RGB LED uses lines 5, 6 and 9 of pinMappingStripe.
+static uint16_t rgbPlaneLines(const uint8_t rgb[3], uint8_t plane) {
+    return (((rgb[0] >> plane) & 1) << 5) | (((rgb[1] >> plane) & 1) << 6) | ((uint16_t)((rgb[2] >> plane) & 1) << 9);
+}
+
+// Gamma 2.2: round(255 * (i / 255)^2.2)
+static const uint8_t gammaTable[256] PROGMEM = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+// a * b / 255 without a division, exact for b = 255
+static inline uint8_t scale8(uint8_t a, uint8_t b) {
+    return ((uint16_t)a * b + 255) >> 8;
+}
+
+// The last step of a modulated slot is 8 units long and shows the low bit planes in turns, so that
+// over 8 slots plane 2 is shown 4 times, plane 1 twice, plane 0 once and nothing once.
+static const uint8_t bamLowPlanes[8] PROGMEM = {2, 1, 2, 0, 2, 1, 2, 0xFF};
+
+constexpr uint8_t HTL_onboard::pinMapping[10];
+constexpr uint8_t HTL_onboard::pinMappingStripe[10];
+constexpr uint8_t HTL_onboard::selectPins[3];
+
+// Only defined for the switches of the library, see HTL_LAYOUT
+extern const volatile uint8_t HTL_LAYOUT = 0;
 
 void HTL_onboard::begin() {
+    beginPins();
+    loadSwitchCalibration();
+    storeFrames();
+    swapFrames(); // Shown from the first slot on, also if it falls into a batch
+}
+
+void HTL_onboard::beginPins() {
     // Initialize all pins as output
     for (int i = 0; i < 10; i++) {
         pinMode(pinMapping[i], OUTPUT);
@@ -192,344 +320,2076 @@ void HTL_onboard::begin() {
     pinMode(A0, INPUT);
     pinMode(A1, INPUT_PULLUP);
 
+    fastOutput = initPorts();
+
     for (int i = 0; i < 3; i++) {
         setMode(i, false);
     }
 }
 
 void HTL_onboard::writeHex(int8_t hexNumber) {
-    setMode(MODE_HEX, true);
     setHexMode(HEX_MODE_HEX);
 
     if (hexNumber < -0x1F || hexNumber > 0x1F) {
+        writeLines(MODE_HEX, 0);
         return;  // Out of range
     }
 
     this->hexNumber = hexNumber;
-
-    if (hexNumber < 0) {
-        digitalWrite(pinMapping[7], LOW);
-        hexNumber = -hexNumber;
-    } else {
-        digitalWrite(pinMapping[7], HIGH);
-    }
-
-    if (hexNumber > 0x0F) {
-        digitalWrite(pinMapping[8], LOW);
-        digitalWrite(pinMapping[9], LOW);
-        hexNumber -= 0x10;
-    }
-    else {
-        digitalWrite(pinMapping[8], HIGH);
-        digitalWrite(pinMapping[9], HIGH);
-    }
-
-    uint8_t value = segmentMap[hexNumber];
-    setPins(value);
+    writeLines(MODE_HEX, storeHexFrame());
 }
 
 void HTL_onboard::writeInt(int8_t intNumber) {
-    setMode(MODE_HEX, true);
     setHexMode(HEX_MODE_DEC);
 
     if (intNumber < -19 || intNumber > 19) {
+        writeLines(MODE_HEX, 0);
         return;  // Out of range
     }
 
     hexNumber = intNumber;
+    writeLines(MODE_HEX, storeHexFrame());
+}
 
-    if (intNumber < 0) {
-        digitalWrite(pinMapping[7], LOW);
-        intNumber = -intNumber;
-    } else {
-        digitalWrite(pinMapping[7], HIGH);
+void HTL_onboard::writeChar(char c) {
+    hexNumber = (int)c;
+    storeHexFrame();
+
+    writeLines(MODE_HEX, hexLines(charSegments(c), false, false));
+}
+
+uint16_t HTL_onboard::hexFrame() {
+    int number = hexNumber;
+
+    switch (HEX_mode) {
+        case HEX_MODE_HEX:
+        case HEX_MODE_DEC: {
+            int base = (HEX_mode == HEX_MODE_HEX) ? 0x10 : 10;
+            if (number <= -2 * base || number >= 2 * base) {
+                return 0; // Out of range
+            }
+
+            bool negative = number < 0;
+            if (negative) {
+                number = -number;
+            }
+
+            bool tens = number >= base;
+            if (tens) {
+                number -= base;
+            }
+
+            return hexLines(pgm_read_byte(&segmentMap[number]), negative, tens);
+        }
+        case HEX_MODE_CHAR:
+            return hexLines(charSegments((char)number), false, false);
+        case HEX_MODE_STRING:
+            return hexLines(strSegments[strInx], false, false);
+#if HTL_PAGED_NUMBERS
+        case HEX_MODE_PAGED_DEC:
+        case HEX_MODE_PAGED_HEX: {
+            uint8_t page = pages[pageBuffer][pageInx];
+            return hexLines(page & 0x7F, page & 0x80, false);
+        }
+#endif
     }
 
-    if (intNumber > 9) {
-        digitalWrite(pinMapping[8], LOW);
-        digitalWrite(pinMapping[9], LOW);
-        intNumber -= 10;
-    } else {
-        digitalWrite(pinMapping[8], HIGH);
-        digitalWrite(pinMapping[9], HIGH);
+    return 0;
+}
+
+uint16_t HTL_onboard::stripeFrame() {
+    switch (stripeMode) {
+        case STRIPE_MODE_BIN:
+            if (ledStripeValue >= 0 && ledStripeValue <= 1023) {
+                return ledStripeValue;
+            }
+            break;
+        case STRIPE_MODE_PROG:
+            if (ledStripeValue >= 0 && ledStripeValue <= 10) {
+                return (1 << ledStripeValue) - 1;
+            }
+            break;
+#if HTL_GRAY_STRIPE
+        case STRIPE_MODE_GRAY: {
+            // The LEDs that are lit at all, the slot shows the bit planes
+            uint16_t lines = 0;
+            for (uint8_t led = 0; led < 10; led++) {
+                if (stripeLevels[led]) {
+                    lines |= (1 << led);
+                }
+            }
+            return lines;
+        }
+#endif
     }
 
-    uint8_t value = segmentMap[intNumber];
-    setPins(value);
+    return 0; // Out of range
 }
 
-void HTL_onboard::writeChar(char c) {
-    setMode(MODE_HEX, true);
+uint16_t HTL_onboard::storeHexFrame() {
+    uint16_t lines = hexFrame();
+    if (!stageFrame(MODE_HEX)) {
+        storeFrame(MODE_HEX, lines);
+    }
+    return lines;
+}
 
-    hexNumber = (int)c;
+uint16_t HTL_onboard::storeStripeFrame() {
+    uint16_t lines = stripeFrame();
+    if (!stageFrame(MODE_STRIPE)) {
+        // The lines and the bit planes change at the same slot boundary, even in timer mode
+        Frame encoded;
+        encodeLines(MODE_STRIPE, lines, encoded);
+        encodeStripeLevels(encoded);
+        publishFrame(encoded, 1 << MODE_STRIPE);
+    }
+    return lines;
+}
 
-    if (c < 32 || c > 127 || (charMap[(uint8_t)c] == 0 && c != ' ')) {
-        // Check if the character has an uppercase or lowercase equivalent in the segmentMap
-        if (c >= 'a' && c <= 'z') {
-            c = (char)toupper(c);  // Convert to uppercase
-        } else if (c >= 'A' && c <= 'Z') {
-            c = (char)tolower(c);  // Convert to lowercase
-        }
+void HTL_onboard::encodeStripeLevels(Frame& encoded) {
+    encoded.stripeGray = stripeMode == STRIPE_MODE_GRAY;
+#if HTL_GRAY_STRIPE
+    if (!encoded.stripeGray) {
+        return;
+    }
 
-        // If still unsupported, default to '0'
-        if (c < 32 || c > 127 || charMap[(uint8_t)c] == 0 && c != ' ') {
-            c = '0';  // Default to '0' if character is out of range or unsupported
+    // Plane b holds bit 8 - STRIPE_GRAY_BITS + b of each intensity
+    for (uint8_t b = 0; b < STRIPE_GRAY_BITS; b++) {
+        encoded.stripePlanes[b] = 0;
+    }
+    for (uint8_t led = 0; led < 10; led++) {
+        uint8_t level = scale8(stripeLevels[led], brightness);
+        if (gammaCorrection) {
+            level = pgm_read_byte(&gammaTable[level]);
+        }
+        level >>= 8 - STRIPE_GRAY_BITS;
+        for (uint8_t b = 0; b < STRIPE_GRAY_BITS; b++) {
+            if (level & (1 << b)) {
+                encoded.stripePlanes[b] |= (1 << led);
+            }
         }
     }
 
-    uint8_t value = charMap[(uint8_t)c];
-    setPins(value);
+#if HTL_FAST_IO
+    for (uint8_t b = 0; b < STRIPE_GRAY_BITS; b++) {
+        linesToPorts(MODE_STRIPE, encoded.stripePlanes[b], encoded.stripePlanePorts[b]);
+    }
+#endif
+#endif
 }
 
+bool HTL_onboard::stageFrame(int mode) {
+    if (frameDepth == 0) {
+        return false;
+    }
 
+    // Also called by the refresh for scrolling strings and animations
+    uint8_t oldSREG = SREG;
+    cli();
+    stagedFrames |= (1 << mode);
+    SREG = oldSREG;
+    return true;
+}
 
-void HTL_onboard::setPins(uint8_t value) {
-    for (int i = 6; i >= 0; i--) {
-        digitalWrite(pinMapping[i], (value & (1 << (6 - i))) ? LOW : HIGH);  // Active low logic
+void HTL_onboard::storeFrame(int mode, uint16_t lines) {
+#if HTL_FAST_IO
+    uint8_t data[HTL_MAX_PORTS];
+    linesToPorts(mode, lines, data);
+#endif
+
+    // The back buffer is shared with the refresh, which may run in the timer interrupt
+    uint8_t oldSREG = SREG;
+    cli();
+    Frame& back = frames[frontFrame ^ 1];
+    back.lines[mode] = lines;
+#if HTL_FAST_IO
+    for (uint8_t p = 0; p < portCount; p++) {
+        back.portData[mode][p] = data[p];
     }
+#endif
+    dirtyFrames |= (1 << mode);
+    SREG = oldSREG;
 }
 
-void HTL_onboard::setMode(int mode, bool state) {
-    // Set Pins to Output
-    for (int i = 0; i < 10; i++) {
-        pinMode(pinMapping[i], OUTPUT);
-        // Set Pins to Off (HIGH)
-        digitalWrite(pinMapping[i], HIGH);
+void HTL_onboard::storeRGBFrame() {
+    if (stageFrame(MODE_RGB)) {
+        return;
     }
 
-    // Ensure the mode is within the bounds of selectPins array
-    if (mode >= 0 && mode < (sizeof(selectPins) / sizeof(selectPins[0]))) {
-        digitalWrite(selectPins[mode], state ? LOW : HIGH);  // Active low logic
+    Frame encoded;
+    encodeRGB(red, green, blue, encoded);
+    publishFrame(encoded, 1 << MODE_RGB);
+}
+
+void HTL_onboard::encodeLines(int mode, uint16_t lines, Frame& encoded) {
+    encoded.lines[mode] = lines;
+#if HTL_FAST_IO
+    linesToPorts(mode, lines, encoded.portData[mode]);
+#endif
+}
+
+void HTL_onboard::encodeRGB(uint8_t red, uint8_t green, uint8_t blue, Frame& encoded) {
+    // The brightness, gamma correction and white balance of the RGB LED are applied to its color
+    encoded.rgb[0] = red;
+    encoded.rgb[1] = green;
+    encoded.rgb[2] = blue;
+    correctColor(encoded.rgb, true);
+
+#if HTL_FAST_IO
+    for (uint8_t plane = 0; plane < 8; plane++) {
+        linesToPorts(MODE_RGB, rgbPlaneLines(encoded.rgb, plane), encoded.rgbPlanes[plane]);
     }
+#endif
 }
 
-void HTL_onboard::setRGB(uint8_t red, uint8_t green, uint8_t blue) {
-    setMode(MODE_RGB, true);
+void HTL_onboard::publishFrame(const Frame& encoded, uint8_t modes) {
+    // Only copies, the encoding is done before, so interrupts are off for a few microseconds
+    uint8_t oldSREG = SREG;
+    cli();
+    Frame& back = frames[frontFrame ^ 1];
+    for (uint8_t mode = MODE_HEX; mode <= MODE_STRIPE; mode++) {
+        if (modes & (1 << mode)) {
+            back.lines[mode] = encoded.lines[mode];
+#if HTL_FAST_IO
+            for (uint8_t p = 0; p < portCount; p++) {
+                back.portData[mode][p] = encoded.portData[mode][p];
+            }
+#endif
+        }
+    }
+    if (modes & (1 << MODE_STRIPE)) {
+        back.stripeGray = encoded.stripeGray;
+#if HTL_GRAY_STRIPE
+        if (encoded.stripeGray) {
+            for (uint8_t b = 0; b < STRIPE_GRAY_BITS; b++) {
+                back.stripePlanes[b] = encoded.stripePlanes[b];
+#if HTL_FAST_IO
+                for (uint8_t p = 0; p < portCount; p++) {
+                    back.stripePlanePorts[b][p] = encoded.stripePlanePorts[b][p];
+                }
+#endif
+            }
+        }
+#endif
+    }
+    if (modes & (1 << MODE_RGB)) {
+        for (uint8_t c = 0; c < 3; c++) {
+            back.rgb[c] = encoded.rgb[c];
+        }
+#if HTL_FAST_IO
+        for (uint8_t plane = 0; plane < 8; plane++) {
+            for (uint8_t p = 0; p < portCount; p++) {
+                back.rgbPlanes[plane][p] = encoded.rgbPlanes[plane][p];
+            }
+        }
+#endif
+    }
+    dirtyFrames |= modes;
+    SREG = oldSREG;
+}
 
-    red = constrain(red, 0, 255);
-    green = constrain(green, 0, 255);
-    blue = constrain(blue, 0, 255);
-    
+void HTL_onboard::storeFrames() {
+    storeHexFrame();
+    storeStripeFrame();
+    storeRGBFrame();
+}
+
+void HTL_onboard::swapFrames() {
+    uint8_t oldSREG = SREG;
+    cli();
+    if (dirtyFrames && !frameHeld) {
+        frontFrame ^= 1;
+        frames[frontFrame ^ 1] = frames[frontFrame]; // The new back buffer starts as a copy of the shown frame
+        dirtyFrames = 0;
+        if (rawFrameWaiting) {
+            rawFrameWaiting = false;
+            rawFrameTime = millis();
+        }
+    }
+    SREG = oldSREG;
+}
+
+bool HTL_onboard::storeRawFrame(uint8_t segments, bool negative, bool tens, uint16_t stripe, uint8_t red, uint8_t green, uint8_t blue) {
     this->red = red;
     this->green = green;
     this->blue = blue;
 
-    // Set the RGB LED pins to the specified intensity
-    analogWrite(5, 255 - red);
-    analogWrite(6, 255 - green);
-    analogWrite(9, 255 - blue);
+    // All three displays are encoded first and change at the same slot boundary, even in timer mode
+    Frame encoded;
+    encodeLines(MODE_HEX, hexLines(segments, negative, tens), encoded);
+    encodeLines(MODE_STRIPE, stripe & 0x3FF, encoded);
+    encoded.stripeGray = false; // Streamed LEDs are on or off
+    encodeRGB(red, green, blue, encoded);
+
+    // Marked in the same critical section as the copy, so the next swap is the one that shows it
+    uint8_t oldSREG = SREG;
+    cli();
+    publishFrame(encoded, (1 << MODE_HEX) | (1 << MODE_STRIPE) | (1 << MODE_RGB));
+    bool replaced = rawFrameWaiting;
+    rawFrameWaiting = true;
+    SREG = oldSREG;
+    return replaced;
 }
 
-void HTL_onboard::setRGB_Multiplex(uint8_t red, uint8_t green, uint8_t blue) {
-    setRed(red);
-    setGreen(green);
-    setBlue(blue);
+bool HTL_onboard::rawFramePending(unsigned long& shownTime) {
+    uint8_t oldSREG = SREG;
+    cli();
+    bool waiting = rawFrameWaiting;
+    shownTime = rawFrameTime;
+    SREG = oldSREG;
+    return waiting;
 }
 
-void HTL_onboard::writeBinary(int binValue) {
-    setMode(MODE_STRIPE, true);
+void HTL_onboard::beginFrame() {
+    if (frameDepth < 255) {
+        frameDepth++;
+    }
+    frameHeld = true;
+}
 
-    // Ensure the binValue is within the range of 0 to 1023 (10 bits)
-    if (binValue < 0 || binValue > 1023) {
-        return; // Out of range
+void HTL_onboard::commitFrame() {
+    if (frameDepth == 0 || --frameDepth > 0) {
+        return; // Not open, or the outer batch publishes
     }
 
-    ledStripeValue = binValue;
+    // Encode each staged display once while the swap is still held, so the refresh
+    // cannot show some of them before the others
+    uint8_t oldSREG = SREG;
+    cli();
+    uint8_t staged = stagedFrames;
+    stagedFrames = 0;
+    SREG = oldSREG;
 
-    // Set each LED according to the corresponding bit in binValue
-    for (int i = 0; i < 10; i++) {
-        digitalWrite(pinMappingStripe[i], (binValue & (1 << i)) ? LOW : HIGH); // Active low logic
+    if (staged & (1 << MODE_HEX)) {
+        storeHexFrame();
+    }
+    if (staged & (1 << MODE_STRIPE)) {
+        storeStripeFrame();
     }
+    if (staged & (1 << MODE_RGB)) {
+        storeRGBFrame();
+    }
+    frameHeld = false;
 }
 
-void HTL_onboard::writeProgress(int progressValue) {
-    setMode(MODE_STRIPE, true);
+bool HTL_onboard::framePending() {
+    return dirtyFrames != 0 || stagedFrames != 0;
+}
 
-    // Ensure the binValue is within the range of 0 to 10 (10 LEDS)
-    if (progressValue < 0 || progressValue > 10) {
-        return; // Out of range
-    }
+void HTL_onboard::outputFrame(int mode) {
+    const Frame& front = frames[frontFrame];
 
-    // Set each LED up to progressValue
-    for (int i = 0; i < progressValue; i++) {
-        digitalWrite(pinMappingStripe[i], LOW); // Active low logic
+    if (mode == MODE_RGB) {
+        writeRGB(front.rgb[0], front.rgb[1], front.rgb[2]);
+        return;
     }
 
-    for (int i = progressValue; i < 10; i++) {
-        digitalWrite(pinMappingStripe[i], HIGH); // Active low logic
+    outputLinesFrame(mode);
+}
+
+void HTL_onboard::outputLinesFrame(int mode) {
+    const Frame& front = frames[frontFrame];
+
+#if HTL_FAST_IO
+    if (fastOutput) {
+        releasePWM();
+        writePorts(mode, front.portData[mode]);
+        return;
     }
+#endif
+
+    writeLines(mode, front.lines[mode]);
 }
 
-void HTL_onboard::setLED(int pin) {
-    setMode(MODE_STRIPE, true);
+void HTL_onboard::writeLines(int mode, uint16_t lines) {
+#if HTL_FAST_IO
+    if (fastOutput) {
+        releasePWM();
 
-    // Ensure the pin number is within the range of 0 to 9
-    if (pin < 0 || pin > 9) {
-        return; // Out of range
+        uint8_t data[HTL_MAX_PORTS];
+        linesToPorts(mode, lines, data);
+        writePorts(mode, data);
+        return;
     }
+#endif
 
-    // Set the specified LED pin to LOW (ON)
-    digitalWrite(pinMappingStripe[pin], LOW);
+    const uint8_t* mapping = (mode == MODE_HEX) ? pinMapping : pinMappingStripe;
 
-    // Update ledStripeValue to reflect the change
-    ledStripeValue |= (1 << pin);
+    setMode(mode, true);
+    for (int i = 0; i < 10; i++) {
+        pinWrite(mapping[i], (lines & (1 << i)) ? LOW : HIGH);  // Active low logic
+    }
 }
 
-void HTL_onboard::clearLED(int pin) {
-    setMode(MODE_STRIPE, true);
+#if HTL_FAST_IO
+void HTL_onboard::linesToPorts(int mode, uint16_t lines, uint8_t data[]) {
+    const uint8_t* lineBits = (mode == MODE_HEX) ? hexLineBits : stripeLineBits;
 
-    // Ensure the pin number is within the range of 0 to 9
-    if (pin < 0 || pin > 9) {
-        return; // Out of range
+    uint8_t on[HTL_MAX_PORTS] = {0};
+    for (int i = 0; i < 10; i++) {
+        if (lines & (1 << i)) {
+            on[lineBits[i] >> 3] |= (1 << (lineBits[i] & 0x07));
+        }
     }
 
-    // Set the specified LED pin to HIGH (OFF)
-    digitalWrite(pinMappingStripe[pin], HIGH);
+    for (uint8_t p = 0; p < portCount; p++) {
+        data[p] = dataMask[p] & ~on[p]; // Active low logic
+    }
+}
 
-    // Update ledStripeValue to reflect the change
-    ledStripeValue &= ~(1 << pin);
+void HTL_onboard::writePorts(int mode, const uint8_t data[]) {
+    // Write the port holding the select line last, so the display is only enabled once all data is valid
+    uint8_t oldSREG = SREG;
+    cli();
+    for (uint8_t p = 0; p < portCount; p++) {
+        if (p != selectPort[mode]) {
+            *outPorts[p] = (*outPorts[p] & ~dataMask[p]) | data[p];
+            ioWrites++;
+        }
+    }
+    uint8_t p = selectPort[mode];
+    *outPorts[p] = ((*outPorts[p] & ~dataMask[p]) | data[p]) & ~selectBit[mode];
+    ioWrites++;
+    SREG = oldSREG;
 }
+#endif
 
-void HTL_onboard::clearStripe() {
-    setMode(MODE_STRIPE, true);
+void HTL_onboard::setMode(int mode, bool state) {
+#if HTL_FAST_IO
+    if (fastOutput) {
+        releasePWM();
+
+        uint8_t oldSREG = SREG;
+        cli();
+        for (uint8_t p = 0; p < portCount; p++) {
+            uint8_t value = *outPorts[p] | dataMask[p]; // Set Pins to Off (HIGH)
+            if (mode >= 0 && mode < 3 && p == selectPort[mode]) {
+                value = state ? (value & ~selectBit[mode]) : (value | selectBit[mode]); // Active low logic
+            }
+            *outPorts[p] = value;
+            ioWrites++;
+        }
+        SREG = oldSREG;
+        return;
+    }
+#endif
 
-    // Turn off all LEDs in the LED-Stripe (set them to HIGH)
+    // Set Pins to Output
     for (int i = 0; i < 10; i++) {
-        digitalWrite(pinMappingStripe[i], HIGH);
+        pinOutput(pinMapping[i]);
+        // Set Pins to Off (HIGH)
+        pinWrite(pinMapping[i], HIGH);
+    }
+
+    // Ensure the mode is within the bounds of selectPins array
+    if (mode >= 0 && mode < (sizeof(selectPins) / sizeof(selectPins[0]))) {
+        pinWrite(selectPins[mode], state ? LOW : HIGH);  // Active low logic
     }
 }
 
-int HTL_onboard::readSwitchState() {
-    // Read the analog voltage on pin A1
-    int analogValue = analogRead(A1);
+void HTL_onboard::blankDisplays() {
+#if HTL_FAST_IO
+    if (fastOutput) {
+        releasePWM();
 
-    // Check the voltage level and determine the switch state
-    if (analogValue > switchNoneThreshold) {
-        return 0; // Both switches are inactive
-    } else if (analogValue > switch1Threshold) {
-        return 2; // Switch 2 is active
-    } else if (analogValue > switch12Threshold) {
-        return 1; // Both switches are active
-    } else {
-        return 3; // Switch 3 is active
+        uint8_t oldSREG = SREG;
+        cli();
+        for (uint8_t p = 0; p < portCount; p++) {
+            *outPorts[p] |= dataMask[p] | selectMask[p]; // Active low logic
+            ioWrites++;
+        }
+        SREG = oldSREG;
+        return;
     }
-}
+#endif
 
-int HTL_onboard::readPot() {
-    return analogRead(A0);
+    setMode(MODE_HEX, false);
+    setMode(MODE_STRIPE, false);
+    setMode(MODE_RGB, false);
 }
 
-void HTL_onboard::cfgSwitches(int switch1Threshold, int switchNoneThreshold, int switch12Threshold) {
-    this->switch1Threshold = switch1Threshold;
-    this->switchNoneThreshold = switchNoneThreshold;
-    this->switch12Threshold = switch12Threshold;
-}
+bool HTL_onboard::initPorts() {
+#if HTL_FAST_IO
+    uint8_t ports[HTL_MAX_PORTS];
+    portCount = 0;
 
-void HTL_onboard::updateMultiplex() {
-    unsigned long currentTime = millis();
-    
-    if (currentTime - lastMultiplexTime >= multiplexInterval) {
-        lastMultiplexTime = currentTime;
+    for (int i = 0; i < HTL_MAX_PORTS; i++) {
+        dataMask[i] = 0;
+        selectMask[i] = 0;
+    }
 
-        // Check if any mode is active
-        bool flag = false;
-        for (int i = 0; i < 3; i++) {
-            if (modesActive[i]) {
-                flag = true;
-                break;
-            }
-        }
-        if (!flag) {
-            return;
+    // Collect the ports of all data and select pins, the stripe uses the same pins as the HEX display
+    for (int i = 0; i < 13; i++) {
+        uint8_t pin = (i < 10) ? pinMapping[i] : selectPins[i - 10];
+        uint8_t port = digitalPinToPort(pin);
+        if (port == NOT_A_PIN) {
+            return false;
         }
 
-        // Cycle through active display modes
-        int nextMode = currentMode;
-        do {
-            nextMode += 1;
-	        if (nextMode > 2) {
-		        nextMode = 0;
-	        }
-        } while (!modesActive[nextMode]);
-
-        // Turn off all displays before switching
-        setMode(MODE_HEX, false);
-        setMode(MODE_STRIPE, false);
-        setMode(MODE_RGB, false);
-
-        switch (nextMode) {
-            case MODE_HEX:
-                switch (HEX_mode) {
-                    case HEX_MODE_HEX:
-                        writeHex(hexNumber);
-                        break;
-                    case HEX_MODE_DEC:
-                        writeInt(hexNumber);
-                        break;
-                    case HEX_MODE_CHAR:
-                        writeChar(hexNumber);
-                        break;
-                    case HEX_MODE_STRING:
-                        if (currentTime - lastStringUpdateTime >= strDelay) {
-                            strInx++;
-                            lastStringUpdateTime = currentTime;
-                            if(strInx >= str.length()) {
-                                strInx = 0;
-                            }
-                        }
-                        writeChar(str[strInx]);
-                        break;
-                }
-                break;
+        uint8_t p = 0;
+        while (p < portCount && ports[p] != port) {
+            p++;
+        }
+        if (p == portCount) {
+            if (portCount == HTL_MAX_PORTS) {
+                return false; // Too many ports, keep the per-pin path
+            }
+            ports[portCount] = port;
+            outPorts[portCount] = portOutputRegister(port);
+            portCount++;
+        }
 
-            case MODE_STRIPE:
-                switch (stripeMode) {
-                    case STRIPE_MODE_BIN:
-                        writeBinary(ledStripeValue);
-                        break;
-                    case STRIPE_MODE_PROG:
-                        writeProgress(ledStripeValue);
-                        break;
-                }
-                break;
+        uint8_t bit = digitalPinToBitMask(pin);
+        if (i < 10) {
+            dataMask[p] |= bit;
 
-            case MODE_RGB:
-                setRGB(red, green, blue); // Update with current RGB values
-                delay(RGB_DELAY);
-                break;
+            uint8_t bitNumber = 0;
+            while ((bit >> bitNumber) > 1) {
+                bitNumber++;
+            }
+            hexLineBits[i] = (p << 3) | bitNumber;
+        } else {
+            selectMask[p] |= bit;
+            selectPort[i - 10] = p;
+            selectBit[i - 10] = bit;
         }
-
-        // Update the currentMode to the next active mode
-        currentMode = nextMode;
     }
-}
 
-void HTL_onboard::setModesMultiplex(const int modes[], int size) {
-    // Reset all modes to inactive
-    for (int i = 0; i < 3; i++) {
-        modesActive[i] = false;
-    }
-    
-    // Set the specified modes to active
-    for (int i = 0; i < size; i++) {
-        int mode = modes[i];
-        if (mode >= 0 && mode < 3) {
-            modesActive[mode] = true;
+    // The stripe lines are a permutation of the HEX lines
+    for (int i = 0; i < 10; i++) {
+        for (int j = 0; j < 10; j++) {
+            if (pinMappingStripe[i] == pinMapping[j]) {
+                stripeLineBits[i] = hexLineBits[j];
+            }
         }
     }
+
+    return true;
+#else
+    return false;
+#endif
 }
 
-void HTL_onboard::setMultiplexInterval(int multiplexInterval) {
-    if (multiplexInterval >= 0) {
-	this -> multiplexInterval = multiplexInterval;
+void HTL_onboard::releasePWM() {
+    if (pwmActive) {
+        // digitalWrite() disconnects the pins from their timers
+        pinWrite(5, HIGH);
+        pinWrite(6, HIGH);
+        pinWrite(9, HIGH);
+        pwmActive = false;
+    }
+}
+
+void HTL_onboard::pinWrite(uint8_t pin, uint8_t level) {
+    digitalWrite(pin, level);
+    ioWrites++;
+}
+
+void HTL_onboard::pinOutput(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+    ioWrites++;
+}
+
+void HTL_onboard::setFastOutput(bool enabled) {
+    if (enabled) {
+        // Port writes only take effect on outputs
+        for (int i = 0; i < 10; i++) {
+            pinMode(pinMapping[i], OUTPUT);
+        }
+        fastOutput = initPorts();
+        storeFrames();
+    } else {
+        fastOutput = false;
+    }
+}
+
+bool HTL_onboard::getFastOutput() {
+    return fastOutput;
+}
+
+int HTL_onboard::getWritesPerFrame() {
+    return lastFrameWrites;
+}
+
+void HTL_onboard::setRGB(uint8_t red, uint8_t green, uint8_t blue) {
+    red = constrain(red, 0, 255);
+    green = constrain(green, 0, 255);
+    blue = constrain(blue, 0, 255);
+    
+    this->red = red;
+    this->green = green;
+    this->blue = blue;
+    storeRGBFrame();
+
+    uint8_t rgb[3] = {red, green, blue};
+    correctColor(rgb, false);
+    writeRGB(rgb[0], rgb[1], rgb[2]);
+}
+
+void HTL_onboard::correctColor(uint8_t rgb[3], bool scaled) {
+    for (uint8_t c = 0; c < 3; c++) {
+        uint8_t value = rgb[c];
+        if (scaled) {
+            value = scale8(value, brightness);
+        }
+        if (gammaCorrection) {
+            value = pgm_read_byte(&gammaTable[value]);
+        }
+        rgb[c] = scale8(value, whiteBalance[c]);
+    }
+}
+
+void HTL_onboard::writeRGB(uint8_t red, uint8_t green, uint8_t blue) {
+    setMode(MODE_RGB, true);
+
+    // Set the RGB LED pins to the specified intensity
+    analogWrite(5, 255 - red);
+    analogWrite(6, 255 - green);
+    analogWrite(9, 255 - blue);
+    ioWrites += 3;
+    pwmActive = true;
+}
+
+void HTL_onboard::setRGB_Multiplex(uint8_t red, uint8_t green, uint8_t blue) {
+    // One frame for all three channels
+    this->red = red;
+    this->green = green;
+    this->blue = blue;
+    storeRGBFrame();
+}
+
+void HTL_onboard::setHSV(uint16_t hue, uint8_t saturation, uint8_t value) {
+    uint8_t r, g, b;
+    hsvToRGB(hue, saturation, value, r, g, b);
+    setRGB(r, g, b);
+}
+
+void HTL_onboard::setHSV_Multiplex(uint16_t hue, uint8_t saturation, uint8_t value) {
+    uint8_t r, g, b;
+    hsvToRGB(hue, saturation, value, r, g, b);
+    setRGB_Multiplex(r, g, b);
+}
+
+void HTL_onboard::setHSL(uint16_t hue, uint8_t saturation, uint8_t lightness) {
+    uint8_t r, g, b;
+    hslToRGB(hue, saturation, lightness, r, g, b);
+    setRGB(r, g, b);
+}
+
+void HTL_onboard::setHSL_Multiplex(uint16_t hue, uint8_t saturation, uint8_t lightness) {
+    uint8_t r, g, b;
+    hslToRGB(hue, saturation, lightness, r, g, b);
+    setRGB_Multiplex(r, g, b);
+}
+
+void HTL_onboard::hsvToRGB(uint16_t hue, uint8_t saturation, uint8_t value, uint8_t& red, uint8_t& green, uint8_t& blue) {
+    hue %= 360;
+    uint8_t sector = hue / 60;
+    uint8_t rest = ((hue - sector * 60) * 255) / 60; // Position in the sector, 0 to 255
+
+    uint8_t p = scale8(value, 255 - saturation);
+    uint8_t q = scale8(value, 255 - scale8(saturation, rest));
+    uint8_t t = scale8(value, 255 - scale8(saturation, 255 - rest));
+
+    switch (sector) {
+        case 0: red = value; green = t; blue = p; break;
+        case 1: red = q; green = value; blue = p; break;
+        case 2: red = p; green = value; blue = t; break;
+        case 3: red = p; green = q; blue = value; break;
+        case 4: red = t; green = p; blue = value; break;
+        default: red = value; green = p; blue = q; break;
+    }
+}
+
+void HTL_onboard::hslToRGB(uint16_t hue, uint8_t saturation, uint8_t lightness, uint8_t& red, uint8_t& green, uint8_t& blue) {
+    // HSL to HSV: value = l + s * min(l, 1 - l), saturation = 2 * (1 - l / value)
+    uint8_t value = lightness + scale8(saturation, min(lightness, (uint8_t)(255 - lightness)));
+    uint8_t hsvSaturation = value ? (uint8_t)(((uint16_t)(value - lightness) * 510) / value) : 0;
+    hsvToRGB(hue, hsvSaturation, value, red, green, blue);
+}
+
+void HTL_onboard::setGammaCorrection(bool enabled) {
+    gammaCorrection = enabled;
+    storeRGBFrame();
+    if (stripeMode == STRIPE_MODE_GRAY) {
+        storeStripeFrame();
+    }
+}
+
+bool HTL_onboard::getGammaCorrection() {
+    return gammaCorrection;
+}
+
+void HTL_onboard::setWhiteBalance(uint8_t red, uint8_t green, uint8_t blue) {
+    whiteBalance[0] = red;
+    whiteBalance[1] = green;
+    whiteBalance[2] = blue;
+    storeRGBFrame();
+}
+
+void HTL_onboard::getWhiteBalance(uint8_t& red, uint8_t& green, uint8_t& blue) {
+    red = whiteBalance[0];
+    green = whiteBalance[1];
+    blue = whiteBalance[2];
+}
+
+bool HTL_onboard::animateRGB(uint8_t effect, unsigned int duration, uint8_t red, uint8_t green, uint8_t blue, uint8_t repeat) {
+    if (effect != ANIM_FADE && effect != ANIM_GRADIENT && effect != ANIM_BLINK) {
+        return false;
+    }
+
+    const uint8_t color[3] = {red, green, blue};
+    return queueAnimation(MODE_RGB, effect, duration, color, 0, effect == ANIM_FADE ? 1 : repeat);
+}
+
+bool HTL_onboard::animateStripe(uint8_t effect, unsigned int duration, int value, uint8_t repeat) {
+    if (effect != ANIM_BLINK && effect != ANIM_CHASE && effect != ANIM_BOUNCE && effect != ANIM_PROGRESS) {
+        return false;
+    }
+
+    const uint8_t color[3] = {0, 0, 0};
+    return queueAnimation(MODE_STRIPE, effect, duration, color, value & 0x3FF, repeat);
+}
+
+bool HTL_onboard::queueAnimation(uint8_t target, uint8_t effect, unsigned int duration, const uint8_t color[3], int value, uint8_t repeat) {
+#if HTL_ANIMATIONS
+    if (animationCount >= ANIMATION_TRACKS) {
+        return false;
+    }
+
+    Animation track;
+    track.target = target;
+    track.effect = effect;
+    track.repeat = repeat;
+    track.started = false;
+    track.phase = 0;
+    // One division here, so that every update only adds
+    track.duration = max(duration, 1U);
+    track.phaseStep = (1UL << 24) / track.duration;
+    track.lastTime = 0;
+    for (uint8_t c = 0; c < 3; c++) {
+        track.from[c] = 0;
+        track.color[c] = color[c];
+    }
+    track.value = value;
+
+    // The table is also read by the timer interrupt
+    uint8_t oldSREG = SREG;
+    cli();
+    animations[animationCount] = track;
+    animationCount++;
+    SREG = oldSREG;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HTL_onboard::stopAnimations(int mode) {
+#if HTL_ANIMATIONS
+    uint8_t oldSREG = SREG;
+    cli();
+    uint8_t i = 0;
+    while (i < animationCount) {
+        if (animations[i].target == mode) {
+            removeAnimation(i);
+        } else {
+            i++;
+        }
+    }
+    SREG = oldSREG;
+
+    if (mode == MODE_STRIPE) {
+        restoreStripe();
+    }
+#endif
+}
+
+uint8_t HTL_onboard::getAnimations(int mode) {
+#if HTL_ANIMATIONS
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < animationCount; i++) {
+        if (animations[i].target == mode) {
+            count++;
+        }
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+#if HTL_ANIMATIONS
+void HTL_onboard::removeAnimation(uint8_t track) {
+    for (uint8_t i = track + 1; i < animationCount; i++) {
+        animations[i - 1] = animations[i];
+    }
+    animationCount--;
+}
+
+void HTL_onboard::restoreStripe() {
+    // No stripe animation is left, so the timer interrupt does not change the stripe meanwhile
+    if (stripeRestoreMode < 0) {
+        return;
+    }
+    stripeMode = stripeRestoreMode;
+    ledStripeValue = stripeRestoreValue;
+    stripeRestoreMode = -1;
+    storeStripeFrame();
+}
+#endif
+
+void HTL_onboard::updateAnimations() {
+#if HTL_ANIMATIONS
+    // Runs in the timer interrupt or in the same context as the sketch, so the table is not changed meanwhile
+    unsigned long now = millis();
+    bool updated[3] = {false, false, false};
+    uint8_t i = 0;
+    while (i < animationCount) {
+        Animation& track = animations[i];
+        if (updated[track.target]) {
+            i++;
+            continue; // Queued behind the running animation of its display
+        }
+        updated[track.target] = true;
+
+        if (!track.started) {
+            track.started = true;
+            track.lastTime = now;
+            track.from[0] = red;
+            track.from[1] = green;
+            track.from[2] = blue;
+            if (track.target == MODE_STRIPE && stripeRestoreMode < 0) {
+                // The first stripe animation switches to STRIPE_MODE_BIN, the last one switches back
+                stripeRestoreMode = stripeMode;
+                stripeRestoreValue = ledStripeValue;
+            }
+            showAnimation(i, 0);
+            i++;
+            continue;
+        }
+
+        unsigned long elapsed = now - track.lastTime;
+        if (elapsed == 0) {
+            i++;
+            continue;
+        }
+        track.lastTime = now;
+
+        // After a stall of a period or more, the whole periods are counted and only the rest
+        // advances the phase, so the product below stays under 1 << 24
+        unsigned long periods = 0;
+        if (elapsed >= track.duration) {
+            periods = elapsed / track.duration;
+            elapsed -= periods * track.duration;
+        }
+        track.phase += track.phaseStep * elapsed;
+        if (track.phase >= (1UL << 24)) {
+            periods++;
+            track.phase &= (1UL << 24) - 1;
+        }
+
+        if (periods) {
+            if (track.repeat == 0 || periods < track.repeat) {
+                // Forever or more periods left
+                if (track.repeat) {
+                    track.repeat -= periods;
+                }
+            } else {
+                // The last period ends with its final frame, the next animation starts in this update
+                uint8_t target = track.target;
+                showAnimation(i, 255);
+                removeAnimation(i);
+                if (target == MODE_STRIPE && !getAnimations(MODE_STRIPE)) {
+                    restoreStripe();
+                }
+                updated[target] = false;
+                continue;
+            }
+        }
+
+        showAnimation(i, track.phase >> 16);
+        i++;
+    }
+#endif
+}
+
+#if HTL_ANIMATIONS
+void HTL_onboard::showAnimation(uint8_t track, uint8_t phase) {
+    const Animation& a = animations[track];
+
+    if (a.target == MODE_RGB) {
+        uint8_t rgb[3];
+        switch (a.effect) {
+            case ANIM_FADE: {
+                // Scale the phase to 0 to 256, so the last frame reaches the target exactly
+                uint16_t weight = phase + (phase >> 7);
+                for (uint8_t c = 0; c < 3; c++) {
+                    int diff = (int)a.color[c] - a.from[c];
+                    rgb[c] = a.from[c] + (int)(((long)diff * weight) >> 8);
+                }
+                break;
+            }
+            case ANIM_GRADIENT: {
+                // Three thirds of the period: red to green, green to blue, blue to red
+                uint16_t position = (uint16_t)phase * 3;
+                uint8_t step = position & 0xFF;
+                uint8_t third = position >> 8;
+                rgb[third] = 255 - step;
+                rgb[(third + 1) % 3] = step;
+                rgb[(third + 2) % 3] = 0;
+                break;
+            }
+            default: // ANIM_BLINK
+                for (uint8_t c = 0; c < 3; c++) {
+                    rgb[c] = (phase < 128) ? a.color[c] : 0;
+                }
+                break;
+        }
+
+        // Only re-encode the frame if the color changed
+        if (rgb[0] != red || rgb[1] != green || rgb[2] != blue) {
+            red = rgb[0];
+            green = rgb[1];
+            blue = rgb[2];
+            storeRGBFrame();
+        }
+        return;
+    }
+
+    int value;
+    switch (a.effect) {
+        case ANIM_CHASE:
+            value = 1 << (((uint16_t)phase * 10) >> 8);
+            break;
+        case ANIM_BOUNCE: {
+            // 18 steps: LED 0 to 9 and back to LED 1
+            uint8_t step = ((uint16_t)phase * 18) >> 8;
+            value = 1 << ((step < 10) ? step : 18 - step);
+            break;
+        }
+        case ANIM_PROGRESS:
+            value = (1 << (((uint16_t)phase * 11) >> 8)) - 1;
+            break;
+        default: // ANIM_BLINK
+            value = (phase < 128) ? a.value : 0;
+            break;
+    }
+
+    if (value != ledStripeValue || stripeMode != STRIPE_MODE_BIN) {
+        stripeMode = STRIPE_MODE_BIN;
+        ledStripeValue = value;
+        storeStripeFrame();
+    }
+}
+#endif
+
+int HTL_onboard::addTask(TaskCallback callback, unsigned int period, uint8_t repeat) {
+#if HTL_TASKS
+    if (!callback) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < MAX_TASKS; i++) {
+        if (tasks[i].state == TASK_FREE) {
+            Task& task = tasks[i];
+            task.callback = callback;
+            task.period = max(period, 1U);
+            task.repeat = repeat;
+            task.longest = 0;
+            task.due = millis() + task.period;
+            if (taskCount == 0) {
+                wheelTime = millis(); // Nothing to catch up on from before the first task
+            }
+            scheduleTask(i);
+            taskCount++;
+            return i;
+        }
+    }
+    return -1;
+#else
+    return -1;
+#endif
+}
+
+void HTL_onboard::removeTask(int task) {
+#if HTL_TASKS
+    if (task < 0 || task >= MAX_TASKS || tasks[task].state == TASK_FREE) {
+        return;
+    }
+    if (tasks[task].state == TASK_WAITING) {
+        // Unlink it from its bucket
+        uint8_t* link = &wheel[tasks[task].due & (TASK_WHEEL_SIZE - 1)];
+        while (*link != task + 1) {
+            link = &tasks[*link - 1].next;
+        }
+        *link = tasks[task].next;
+    }
+    readyTasks &= ~(1 << task);
+    tasks[task].state = TASK_FREE;
+    taskCount--;
+#endif
+}
+
+unsigned int HTL_onboard::getTaskTime(int task) {
+#if HTL_TASKS
+    if (task < 0 || task >= MAX_TASKS) {
+        return 0;
+    }
+    return tasks[task].longest;
+#else
+    return 0;
+#endif
+}
+
+#if HTL_TASKS
+void HTL_onboard::scheduleTask(uint8_t task) {
+    uint8_t& bucket = wheel[tasks[task].due & (TASK_WHEEL_SIZE - 1)];
+    tasks[task].next = bucket;
+    tasks[task].state = TASK_WAITING;
+    bucket = task + 1;
+}
+#endif
+
+void HTL_onboard::updateTasks() {
+#if HTL_TASKS
+    unsigned long currentTime = millis();
+
+    // One bucket per millisecond since the last update, each bucket once after a longer gap
+    unsigned long ticks = min(currentTime - wheelTime, (unsigned long)TASK_WHEEL_SIZE);
+    for (unsigned long tick = currentTime - ticks + 1; ticks > 0; tick++, ticks--) {
+        uint8_t* link = &wheel[tick & (TASK_WHEEL_SIZE - 1)];
+        while (*link) {
+            uint8_t i = *link - 1;
+            if ((long)(currentTime - tasks[i].due) >= 0) {
+                *link = tasks[i].next;
+                tasks[i].state = TASK_READY;
+                readyTasks |= (1 << i);
+            } else {
+                link = &tasks[i].next; // Due in a later turn of the wheel
+            }
+        }
+    }
+    wheelTime = currentTime;
+
+    while (readyTasks) {
+        uint8_t i = 0;
+        while (!(readyTasks & (1 << i))) {
+            i++;
+        }
+        Task& task = tasks[i];
+        if (!taskFits(task.longest)) {
+            return; // Waits for the gap after the next slot
+        }
+        readyTasks &= ~(1 << i);
+        task.state = TASK_RUNNING;
+
+        unsigned long start = micros();
+        task.callback();
+        unsigned long runMicros = micros() - start;
+        task.longest = (unsigned int)min(max(runMicros, (unsigned long)task.longest), 65535UL);
+
+        if (task.state != TASK_RUNNING) {
+            continue; // Removed by its callback
+        }
+        if (task.repeat == 1) {
+            task.state = TASK_FREE;
+            taskCount--;
+            continue;
+        }
+        if (task.repeat) {
+            task.repeat--;
+        }
+
+        // Keep the period; a task that fell a whole period behind starts over from now
+        task.due += task.period;
+        unsigned long now = millis();
+        if ((long)(now - task.due) >= 0) {
+            task.due = now + task.period;
+        }
+        scheduleTask(i);
+    }
+#endif
+}
+
+bool HTL_onboard::taskFits(unsigned int runMicros) {
+    unsigned long slotLength = (unsigned long)multiplexInterval * 1000UL;
+    if (timerMultiplex || slotLength == 0 || !(modesActive[MODE_HEX] || modesActive[MODE_STRIPE] || modesActive[MODE_RGB])) {
+        return true; // No polled slot to keep on time
+    }
+    if (bamSlot) {
+        return false; // The bit-angle modulation steps are too short, the next slot follows the modulated slot
+    }
+
+    unsigned long elapsed = micros() - slotStartMicros;
+    if (runMicros > slotLength) {
+        return elapsed < slotLength / 2;
+    }
+    return elapsed < slotLength && runMicros <= slotLength - elapsed;
+}
+
+void HTL_onboard::setRGBMode(int mode) {
+    if (mode == RGB_MODE_PWM || mode == RGB_MODE_BAM) {
+        rgbMode = mode;
+    }
+}
+
+int HTL_onboard::getRGBMode() {
+    return rgbMode;
+}
+
+void HTL_onboard::beginBAMSlot(int mode) {
+    releasePWM();
+
+#if HTL_FAST_IO
+    if (!fastOutput)
+#endif
+    {
+        setMode(mode, true);
+    }
+
+    bamMode = mode;
+    bamSlot = true;
+    bamPhase = 0;
+    if (timerMultiplex) {
+        // One unit is one timer tick, switch to the slower modulation clock for the slot
+        uint8_t cs = timerBAMCS;
+#if HTL_FAST_IO
+        if (!fastOutput)
+#endif
+        {
+            // Writing the ten stripe pins one by one takes longer than a 16 microsecond step
+            if (mode == MODE_STRIPE) {
+                cs = max(cs, 5);
+            }
+        }
+        TCCR2B = cs;
+        TCNT2 = 0;
+        updateTimerDimming();
+    } else {
+        bamPhaseStart = micros();
+        bamPhaseLength = 0;
+    }
+
+    outputBAMStep();
+}
+
+void HTL_onboard::outputBAMStep() {
+    // Bit planes 7 to 3 are held for 2^plane units, the last step for 8 units
+    uint8_t plane;
+    uint8_t units;
+    if (bamPhase < RGB_BAM_STEPS - 1) {
+        plane = 7 - bamPhase;
+        units = 1 << plane;
+    } else {
+        // Each display dithers on its own, the slots of the two may alternate
+#if HTL_GRAY_STRIPE
+        uint8_t& dither = (bamMode == MODE_RGB) ? rgbDither : stripeDither;
+#else
+        uint8_t& dither = rgbDither;
+#endif
+        plane = pgm_read_byte(&bamLowPlanes[dither]);
+        dither = (dither + 1) & 0x07;
+        units = 8;
+    }
+    bamPhase++;
+
+    const Frame& front = frames[frontFrame];
+
+#if HTL_GRAY_STRIPE
+    // The stripe keeps only its upper STRIPE_GRAY_BITS planes, the lower ones show nothing
+    bool stripePlane = plane < 8 && plane >= 8 - STRIPE_GRAY_BITS;
+    uint8_t stripeIndex = plane - (8 - STRIPE_GRAY_BITS);
+#endif
+
+#if HTL_FAST_IO
+    if (fastOutput) {
+        const uint8_t* data = dataMask;
+        if (bamMode == MODE_RGB) {
+            if (plane < 8) {
+                data = front.rgbPlanes[plane];
+            }
+        }
+#if HTL_GRAY_STRIPE
+        else if (stripePlane) {
+            data = front.stripePlanePorts[stripeIndex];
+        }
+#endif
+        writePorts(bamMode, data);
+    } else
+#endif
+    if (bamMode == MODE_RGB) {
+        // The RGB LED is already selected, only its three lines change
+        uint16_t lines = (plane < 8) ? rgbPlaneLines(front.rgb, plane) : 0;
+        pinWrite(5, (lines & (1 << 5)) ? LOW : HIGH);
+        pinWrite(6, (lines & (1 << 6)) ? LOW : HIGH);
+        pinWrite(9, (lines & (1 << 9)) ? LOW : HIGH);
+    }
+#if HTL_GRAY_STRIPE
+    else {
+        uint16_t lines = stripePlane ? front.stripePlanes[stripeIndex] : 0;
+        for (int i = 0; i < 10; i++) {
+            pinWrite(pinMappingStripe[i], (lines & (1 << i)) ? LOW : HIGH);
+        }
+    }
+#endif
+
+    if (timerMultiplex) {
+        OCR2A = units - 1;
+    } else {
+        bamPhaseStart += bamPhaseLength;
+        bamPhaseLength = units * RGB_BAM_UNIT;
+    }
+}
+
+void HTL_onboard::endBAMSlot() {
+    bamSlot = false;
+    if (timerMultiplex) {
+        TCCR2B = timerSlotCS;
+        OCR2A = timerSlotTop;
+        TCNT2 = 0;
+        updateTimerDimming();
+    }
+}
+
+void HTL_onboard::updateTimerDimming() {
+    if (!timerMultiplex) {
+        return;
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+    if (brightness < 255 && !bamSlot) {
+        // Compare B ends the on-time, compare A starts the next slot
+        OCR2B = ((uint16_t)(timerSlotTop + 1) * brightness) >> 8;
+        TIFR2 = (1 << OCF2B);
+        TIMSK2 |= (1 << OCIE2B);
+    } else {
+        TIMSK2 &= ~(1 << OCIE2B);
+    }
+    SREG = oldSREG;
+}
+
+void HTL_onboard::writeBinary(int binValue) {
+    // Ensure the binValue is within the range of 0 to 1023 (10 bits)
+    if (binValue < 0 || binValue > 1023) {
+        setMode(MODE_STRIPE, true);
+        return; // Out of range
+    }
+
+    ledStripeValue = binValue;
+    storeStripeFrame();
+
+    // Set each LED according to the corresponding bit in binValue
+    writeLines(MODE_STRIPE, binValue);
+}
+
+void HTL_onboard::writeProgress(int progressValue) {
+    // Ensure the binValue is within the range of 0 to 10 (10 LEDS)
+    if (progressValue < 0 || progressValue > 10) {
+        setMode(MODE_STRIPE, true);
+        return; // Out of range
+    }
+
+    // Set each LED up to progressValue
+    writeLines(MODE_STRIPE, (1 << progressValue) - 1);
+}
+
+void HTL_onboard::setLED(int pin) {
+    // Ensure the pin number is within the range of 0 to 9
+    if (pin < 0 || pin > 9) {
+        setMode(MODE_STRIPE, true);
+        return; // Out of range
+    }
+
+    // Set the specified LED pin to LOW (ON)
+    writeLines(MODE_STRIPE, 1 << pin);
+
+    // Update ledStripeValue to reflect the change
+    ledStripeValue |= (1 << pin);
+    storeStripeFrame();
+}
+
+void HTL_onboard::clearLED(int pin) {
+    setMode(MODE_STRIPE, true);
+
+    // Ensure the pin number is within the range of 0 to 9
+    if (pin < 0 || pin > 9) {
+        return; // Out of range
+    }
+
+    // Update ledStripeValue to reflect the change
+    ledStripeValue &= ~(1 << pin);
+    storeStripeFrame();
+}
+
+void HTL_onboard::clearStripe() {
+    // Turn off all LEDs in the LED-Stripe
+    setMode(MODE_STRIPE, true);
+}
+
+int HTL_onboard::readSwitchState() {
+    // Read the analog voltage on pin A1
+    int analogValue = adcSampler ? latestSample(ANALOG_SWITCHES) : analogRead(A1);
+
+    return switchState(analogValue);
+}
+
+int HTL_onboard::switchState(int analogValue) {
+    // Check the voltage level and determine the switch state
+    if (analogValue > switchNoneThreshold) {
+        return 0; // Both switches are inactive
+    } else if (analogValue > switch1Threshold) {
+        return 2; // Switch 2 is active
+    } else if (analogValue > switch12Threshold) {
+        return 1; // Both switches are active
+    } else {
+        return 3; // Switch 3 is active
+    }
+}
+
+int HTL_onboard::readPot() {
+    return readPotHighRes() >> getPotOversampling();
+}
+
+unsigned int HTL_onboard::readPotHighRes() {
+    if (!potFilterActive()) {
+        return adcSampler ? latestSample(ANALOG_POT) : analogRead(A0);
+    }
+
+#if HTL_POT_FILTER
+    if (!adcSampler) {
+        while (!filterPotSample(analogRead(A0))) {
+        }
+    } else if (!potPrimed) {
+        return latestSample(ANALOG_POT) << potOversampling; // The interrupt has not filtered a value yet
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+    unsigned int value = potFiltered;
+    SREG = oldSREG;
+    return value;
+#else
+    return 0; // Not reached, the filter is never active
+#endif
+}
+
+#if HTL_POT_FILTER
+bool HTL_onboard::filterPotSample(uint16_t raw) {
+    // Oversample and decimate: the sum of 4^n samples shifted right by n has n extra bits
+    potSum += raw;
+    if (++potSumCount < (1 << (2 * potOversampling))) {
+        return false;
+    }
+    uint16_t value = potSum >> potOversampling;
+    potSum = 0;
+    potSumCount = 0;
+
+    // Median of the latest values removes single spikes
+    if (potMedian > 1) {
+        potHistory[potHistoryIndex] = value;
+        potHistoryIndex = (potHistoryIndex + 1) % potMedian;
+        if (++potHistoryCount < potMedian) {
+            return false; // A median of a partial window would pass a spike at the start
+        }
+        potHistoryCount = potMedian;
+
+        uint16_t sorted[POT_MEDIAN_MAX];
+        for (uint8_t i = 0; i < potHistoryCount; i++) {
+            uint16_t v = potHistory[i];
+            uint8_t j = i;
+            for (; j > 0 && sorted[j - 1] > v; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = v;
+        }
+        value = sorted[potHistoryCount / 2];
+    }
+
+    // Exponential moving average in fixed point with 4 fractional bits
+    if (potSmoothing) {
+        if (!potPrimed) {
+            potAverage = (long)value << 4;
+        }
+        potAverage += (((long)value << 4) - potAverage) >> potSmoothing;
+        value = (uint16_t)((potAverage + 8) >> 4);
+    }
+
+    // Hysteresis: follow only changes larger than the deadband, snap to the ends
+    if (potHysteresis && potPrimed) {
+        uint16_t band = (uint16_t)potHysteresis << potOversampling;
+        uint16_t top = 1023 << potOversampling;
+        if (value <= band) {
+            value = 0;
+        } else if (value >= top - band) {
+            value = top;
+        } else if ((value > potFiltered ? value - potFiltered : potFiltered - value) <= band) {
+            value = potFiltered;
+        }
+    }
+
+    potFiltered = value;
+    potPrimed = true;
+    return true;
+}
+#endif
+
+#if HTL_POT_FILTER
+void HTL_onboard::resetPotFilter() {
+    uint8_t oldSREG = SREG;
+    cli();
+    potSum = 0;
+    potSumCount = 0;
+    potHistoryCount = 0;
+    potHistoryIndex = 0;
+    potPrimed = false;
+    SREG = oldSREG;
+}
+#endif
+
+bool HTL_onboard::potFilterActive() {
+#if HTL_POT_FILTER
+    return potOversampling || potMedian > 1 || potSmoothing || potHysteresis;
+#else
+    return false;
+#endif
+}
+
+void HTL_onboard::setPotOversampling(uint8_t bits) {
+#if HTL_POT_FILTER
+    potOversampling = min(bits, POT_MAX_EXTRA_BITS);
+    resetPotFilter();
+#endif
+}
+
+uint8_t HTL_onboard::getPotOversampling() {
+#if HTL_POT_FILTER
+    return potOversampling;
+#else
+    return 0;
+#endif
+}
+
+void HTL_onboard::setPotMedian(uint8_t size) {
+#if HTL_POT_FILTER
+    // Only odd sizes have a middle value
+    size = constrain(size, 1, POT_MEDIAN_MAX);
+    potMedian = size | 1;
+    resetPotFilter();
+#endif
+}
+
+uint8_t HTL_onboard::getPotMedian() {
+#if HTL_POT_FILTER
+    return potMedian;
+#else
+    return 1;
+#endif
+}
+
+void HTL_onboard::setPotSmoothing(uint8_t shift) {
+#if HTL_POT_FILTER
+    potSmoothing = min(shift, POT_MAX_SMOOTHING);
+    resetPotFilter();
+#endif
+}
+
+uint8_t HTL_onboard::getPotSmoothing() {
+#if HTL_POT_FILTER
+    return potSmoothing;
+#else
+    return 0;
+#endif
+}
+
+void HTL_onboard::setPotHysteresis(uint8_t deadband) {
+#if HTL_POT_FILTER
+    potHysteresis = deadband;
+    resetPotFilter();
+#endif
+}
+
+uint8_t HTL_onboard::getPotHysteresis() {
+#if HTL_POT_FILTER
+    return potHysteresis;
+#else
+    return 0;
+#endif
+}
+
+int HTL_onboard::latestSample(int input) {
+    uint8_t oldSREG = SREG;
+    cli();
+    int value = adcValues[input];
+    SREG = oldSREG;
+    return value;
+}
+
+void HTL_onboard::samplerTick() {
+    uint8_t input = adcInput;
+    unsigned long now = micros();
+
+    adcValues[input] = ADC;
+    sampleTimes[input] = now;
+#if HTL_SWITCH_EVENTS
+    if (input == ANALOG_SWITCHES) {
+        debounceSwitches(adcValues[input], now);
+    }
+#endif
+#if HTL_POT_FILTER
+    if (input == ANALOG_POT && potFilterActive()) {
+        filterPotSample(adcValues[input]);
+    }
+#endif
+    if (++sampleCounts[input] >= SAMPLE_RATE_WINDOW) {
+        rateWindowMicros[input] = now - rateWindowStart[input];
+        rateWindowStart[input] = now;
+        sampleCounts[input] = 0;
+    }
+
+    // Alternate between the potentiometer (A0) and the switches (A1)
+    input ^= 1;
+    adcInput = input;
+    ADMUX = (ADMUX & 0xF0) | input;
+    ADCSRA |= (1 << ADSC);
+}
+
+#if HTL_SWITCH_EVENTS
+void HTL_onboard::debounceSwitches(int analogValue, unsigned long now) {
+    // Switch bits of the states returned by readSwitchState()
+    static const uint8_t stateSwitches[4] PROGMEM = {0, SWITCH_S2 | SWITCH_S3, SWITCH_S2, SWITCH_S3};
+    uint8_t sample = pgm_read_byte(&stateSwitches[switchState(analogValue)]);
+
+    if (sample != switchCandidate) {
+        switchCandidate = sample;
+        candidateSince = now;
+        return;
+    }
+
+    if (sample != switchStable) {
+        if (now - candidateSince < SWITCH_DEBOUNCE_MS * 1000UL) {
+            return;
+        }
+
+        uint8_t released = switchStable & ~sample;
+        uint8_t pressed = sample & ~switchStable;
+        for (uint8_t sw = SWITCH_S2; sw <= SWITCH_S3; sw <<= 1) {
+            if (released & sw) {
+                pushSwitchEvent(SWITCH_EVENT_RELEASE, sw);
+            }
+        }
+        for (uint8_t sw = SWITCH_S2; sw <= SWITCH_S3; sw <<= 1) {
+            if (pressed & sw) {
+                pushSwitchEvent(SWITCH_EVENT_PRESS, sw);
+            }
+        }
+        if (sample == (SWITCH_S2 | SWITCH_S3)) {
+            pushSwitchEvent(SWITCH_EVENT_BOTH, sample);
+        }
+
+        switchStable = sample;
+        stableSince = now;
+        longPressSent = false;
+    } else if (sample && !longPressSent && now - stableSince >= SWITCH_LONG_PRESS_MS * 1000UL) {
+        pushSwitchEvent(SWITCH_EVENT_LONG_PRESS, sample);
+        longPressSent = true;
+    }
+}
+#endif
+
+#if HTL_SWITCH_EVENTS
+void HTL_onboard::pushSwitchEvent(uint8_t type, uint8_t switches) {
+    uint8_t head = eventHead;
+    uint8_t next = (head + 1) & (SWITCH_EVENT_QUEUE - 1);
+    if (next == eventTail) {
+        lostSwitchEvents++;
+        return; // Queue full
+    }
+
+    switchEvents[head].type = type;
+    switchEvents[head].switches = switches;
+    switchEvents[head].time = millis();
+    eventHead = next; // Publish the entry after it is complete
+}
+#endif
+
+bool HTL_onboard::getSwitchEvent(SwitchEvent& event) {
+#if HTL_SWITCH_EVENTS
+    uint8_t tail = eventTail;
+    if (tail == eventHead) {
+        return false;
+    }
+
+    event = switchEvents[tail];
+    eventTail = (tail + 1) & (SWITCH_EVENT_QUEUE - 1);
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint8_t HTL_onboard::switchEventsAvailable() {
+#if HTL_SWITCH_EVENTS
+    return (eventHead - eventTail) & (SWITCH_EVENT_QUEUE - 1);
+#else
+    return 0;
+#endif
+}
+
+unsigned int HTL_onboard::getLostSwitchEvents() {
+#if HTL_SWITCH_EVENTS
+    uint8_t oldSREG = SREG;
+    cli();
+    unsigned int lost = lostSwitchEvents;
+    SREG = oldSREG;
+    return lost;
+#else
+    return 0;
+#endif
+}
+
+uint8_t HTL_onboard::getSwitches() {
+#if HTL_SWITCH_EVENTS
+    return switchStable;
+#else
+    return 0;
+#endif
+}
+
+unsigned long HTL_onboard::getSampleAge(int input) {
+    if (!adcSampler || input < 0 || input > 1) {
+        return 0;
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+    unsigned long sampleTime = sampleTimes[input];
+    SREG = oldSREG;
+    return micros() - sampleTime;
+}
+
+unsigned int HTL_onboard::getSampleRate(int input) {
+    if (!adcSampler || input < 0 || input > 1) {
+        return 0;
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+    unsigned long windowMicros = rateWindowMicros[input];
+    unsigned long count = sampleCounts[input];
+    unsigned long windowStart = rateWindowStart[input];
+    SREG = oldSREG;
+
+    if (windowMicros) {
+        return (unsigned long)SAMPLE_RATE_WINDOW * 1000000UL / windowMicros;
+    }
+
+    // The first window is not complete yet
+    unsigned long elapsed = micros() - windowStart;
+    return elapsed ? count * 1000000UL / elapsed : 0;
+}
+
+void HTL_onboard::cfgSwitches(int switch1Threshold, int switchNoneThreshold, int switch12Threshold) {
+    // The ADC interrupt debounces with the thresholds
+    uint8_t oldSREG = SREG;
+    cli();
+    this->switch1Threshold = switch1Threshold;
+    this->switchNoneThreshold = switchNoneThreshold;
+    this->switch12Threshold = switch12Threshold;
+    SREG = oldSREG;
+}
+
+void HTL_onboard::updateMultiplex() {
+#if HTL_MULTIPLEX_STATS
+    recordLoopGap();
+#endif
+    pollMultiplex();
+    if (taskCount) {
+        updateTasks();
+    }
+}
+
+void HTL_onboard::pollMultiplex() {
+    if (timerMultiplex) {
+        return; // Slots are driven by the timer interrupt
+    }
+
+    // The steps of a bit-angle modulated slot are timed independent of the multiplex interval
+    if (bamSlot) {
+        if (micros() - bamPhaseStart >= bamPhaseLength) {
+            lastMultiplexTime = millis();
+            multiplexTick();
+        }
+        return;
+    }
+
+    unsigned long currentTime = millis();
+    
+    if (currentTime - lastMultiplexTime >= multiplexInterval) {
+        lastMultiplexTime = currentTime;
+
+        multiplexTick();
+
+        if (currentMode == MODE_RGB && modesActive[MODE_RGB] && rgbMode == RGB_MODE_PWM) {
+            delay(RGB_DELAY);
+        }
+    } else if (brightness < 255 && !slotDimmed) {
+        // Turn the display off once its share of the interval is over
+        unsigned long onTime = ((unsigned long)multiplexInterval * 1000UL * brightness) / 255;
+        if (micros() - slotStartMicros >= onTime) {
+            multiplexBlank();
+            slotDimmed = true;
+        }
+    }
+}
+
+void HTL_onboard::multiplexTick() {
+    // A bit-angle modulated slot continues with its next bit plane until all steps were shown
+    if (bamSlot) {
+        if (bamPhase < RGB_BAM_STEPS && modesActive[bamMode]) {
+            outputBAMStep();
+            return;
+        }
+        endBAMSlot();
+    }
+
+    // Check if any mode is active
+    bool flag = false;
+    for (int i = 0; i < 3; i++) {
+        if (modesActive[i]) {
+            flag = true;
+            break;
+        }
+    }
+    if (!flag) {
+        return;
+    }
+
+    int nextMode = nextSlotMode(modesActive);
+    uint16_t slotStartWrites = ioWrites;
+
+    if (animationCount) {
+        updateAnimations();
+    }
+    if (nextMode == MODE_HEX) {
+        advanceString();
+    }
+
+    startSlot();
+    if (nextMode == MODE_RGB) {
+        outputRGBSlot();
+    } else if (nextMode == MODE_STRIPE) {
+        outputStripeSlot();
+    } else {
+        outputLinesFrame(nextMode);
+    }
+    finishSlot(nextMode, slotStartWrites);
+}
+
+int HTL_onboard::nextSlotMode(const bool active[3]) {
+    // Cycle through active display modes, each mode keeps its weight in consecutive slots
+    int nextMode = currentMode;
+    if (slotsLeft > 0 && active[currentMode]) {
+        slotsLeft--;
+    } else {
+        do {
+            nextMode += 1;
+            if (nextMode > 2) {
+                nextMode = 0;
+            }
+        } while (!active[nextMode]);
+        slotsLeft = modeWeights[nextMode] - 1;
+    }
+    return nextMode;
+}
+
+void HTL_onboard::advanceString() {
+    if (HEX_mode < HEX_MODE_STRING) {
+        return;
+    }
+
+    unsigned long currentTime = millis();
+    if (currentTime - lastStringUpdateTime >= strDelay) {
+        lastStringUpdateTime = currentTime;
+        if (HEX_mode == HEX_MODE_STRING) {
+            strInx++;
+            if(strInx >= strLength) {
+                strInx = 0;
+            }
+            hexNumber = str[strInx];
+        }
+#if HTL_PAGED_NUMBERS
+        else {
+            pageInx++;
+            if (pageInx >= pageCounts[pageBuffer]) {
+                // A new number starts with the next round
+                pageInx = 0;
+                if (pagesPending) {
+                    pageBuffer ^= 1;
+                    pagesPending = false;
+                }
+            }
+        }
+#endif
+        storeHexFrame();
+    }
+}
+
+void HTL_onboard::startSlot() {
+#if HTL_MULTIPLEX_STATS
+    recordSlot();
+#endif
+
+    // Publish frames changed by the setters at the slot boundary
+    if (dirtyFrames) {
+        swapFrames();
+    }
+
+    // Turn off all displays before switching
+    blankDisplays();
+}
+
+void HTL_onboard::outputRGBSlot() {
+    if (rgbMode == RGB_MODE_BAM) {
+        beginBAMSlot(MODE_RGB);
+    } else {
+        outputFrame(MODE_RGB);
+    }
+}
+
+void HTL_onboard::outputStripeSlot() {
+    if (frames[frontFrame].stripeGray) {
+        beginBAMSlot(MODE_STRIPE);
+    } else {
+        outputLinesFrame(MODE_STRIPE);
+    }
+}
+
+void HTL_onboard::finishSlot(int mode, uint16_t slotStartWrites) {
+    // Polled slots are dimmed by updateMultiplex(), timer slots by the compare B interrupt
+    if ((brightness < 255 || taskCount) && !timerMultiplex) {
+        slotStartMicros = micros();
+        slotDimmed = false;
+    }
+
+    // Update the currentMode to the next active mode
+    currentMode = mode;
+    lastFrameWrites = ioWrites - slotStartWrites;
+}
+
+#if HTL_MULTIPLEX_STATS
+void HTL_onboard::recordSlot() {
+    unsigned long now = micros();
+
+    if (statsStarted) {
+        // The slot that ends now was shown in currentMode
+        unsigned long interval = now - statsLastSlot;
+        stats.modeMicros[currentMode] += interval;
+
+        if (stats.minInterval == 0 || interval < stats.minInterval) {
+            stats.minInterval = interval;
+        }
+        if (interval > stats.maxInterval) {
+            stats.maxInterval = interval;
+        }
+        if (stats.slots == 1) {
+            statsAverage = interval << 4;
+        } else {
+            statsAverage = statsAverage - statsAverage / 16 + interval;
+        }
+        stats.avgInterval = statsAverage >> 4;
+
+        // Lateness against the set interval, in bins that double in width
+        unsigned long nominal = timerMultiplex ? timerSlotMicros : (unsigned long)multiplexInterval * 1000UL;
+        uint8_t bin = 0;
+        if (interval + 64 >= nominal) {
+            unsigned long late = (interval > nominal) ? interval - nominal : 0;
+            bin = 1;
+            for (unsigned long limit = 64; late >= limit && bin < STATS_BINS - 1; limit <<= 1) {
+                bin++;
+            }
+            if (nominal > 0) {
+                if (late > nominal / 4) {
+                    stats.lateSlots++;
+                }
+                stats.missedSlots += late / nominal;
+            }
+        }
+        stats.histogram[bin]++;
+    } else {
+        statsStarted = true;
+        statsWindowStart = now;
+    }
+    statsLastSlot = now;
+    stats.slots++;
+
+    statsWindowSlots++;
+    if (now - statsWindowStart >= 1000000UL) {
+        stats.slotsPerSecond = statsWindowSlots;
+        statsWindowSlots = 0;
+        statsWindowStart = now;
+    }
+}
+
+void HTL_onboard::recordLoopGap() {
+    unsigned long now = micros();
+    if (statsLastUpdate != 0 && now - statsLastUpdate > stats.maxLoopGap) {
+        stats.maxLoopGap = now - statsLastUpdate;
+    }
+    statsLastUpdate = now;
+}
+#endif
+
+bool HTL_onboard::getMultiplexStats(MultiplexStats& stats) {
+#if HTL_MULTIPLEX_STATS
+    // Timer slots record in the interrupt
+    uint8_t oldSREG = SREG;
+    cli();
+    stats = this->stats;
+    SREG = oldSREG;
+    return true;
+#else
+    memset(&stats, 0, sizeof(stats));
+    return false;
+#endif
+}
+
+void HTL_onboard::resetMultiplexStats() {
+#if HTL_MULTIPLEX_STATS
+    uint8_t oldSREG = SREG;
+    cli();
+    memset(&stats, 0, sizeof(stats));
+    statsStarted = false;
+    statsAverage = 0;
+    statsWindowSlots = 0;
+    statsLastUpdate = 0;
+    SREG = oldSREG;
+#endif
+}
+
+void HTL_onboard::printMultiplexStats(Print& out) {
+    MultiplexStats s;
+    if (!getMultiplexStats(s)) {
+        out.println(F("multiplex stats off, set HTL_MULTIPLEX_STATS to 1"));
+        return;
+    }
+
+    // slots 5000 999/s interval 1000 1012 2048 us late 12 missed 12 loop 1180 us
+    out.print(F("slots "));
+    out.print(s.slots);
+    out.print(' ');
+    out.print(s.slotsPerSecond);
+    out.print(F("/s interval "));
+    out.print(s.minInterval);
+    out.print(' ');
+    out.print(s.avgInterval);
+    out.print(' ');
+    out.print(s.maxInterval);
+    out.print(F(" us late "));
+    out.print(s.lateSlots);
+    out.print(F(" missed "));
+    out.print(s.missedSlots);
+    out.print(F(" loop "));
+    out.print(s.maxLoopGap);
+    out.println(F(" us"));
+
+    // late early 0 <64 4980 <128 3 <256 0 <512 0 <1k 5 <2k 12 more 0
+    static const char binNames[STATS_BINS][6] PROGMEM = {"early", "<64", "<128", "<256", "<512", "<1k", "<2k", "more"};
+    out.print(F("late"));
+    for (uint8_t bin = 0; bin < STATS_BINS; bin++) {
+        out.print(' ');
+        out.print((const __FlashStringHelper*)binNames[bin]);
+        out.print(' ');
+        out.print(s.histogram[bin]);
+    }
+    out.println();
+
+    // HEX 33% STRIPE 33% RGB 34%
+    static const char modeNames[3][7] PROGMEM = {"HEX", "STRIPE", "RGB"};
+    unsigned long total = (s.modeMicros[0] + s.modeMicros[1] + s.modeMicros[2]) / 100;
+    for (uint8_t mode = 0; mode < 3; mode++) {
+        out.print((const __FlashStringHelper*)modeNames[mode]);
+        out.print(' ');
+        out.print(total ? s.modeMicros[mode] / total : 0);
+        out.print(mode < 2 ? F("% ") : F("%"));
+    }
+    out.println();
+}
+
+void HTL_onboard::setModesMultiplex(const int modes[], int size) {
+    // Reset all modes to inactive, each with one slot per round
+    for (int i = 0; i < 3; i++) {
+        modesActive[i] = false;
+        modeWeights[i] = 1;
+    }
+    
+    // Set the specified modes to active
+    for (int i = 0; i < size; i++) {
+        int mode = modes[i];
+        if (mode >= 0 && mode < 3) {
+            modesActive[mode] = true;
+        }
+    }
+}
+
+void HTL_onboard::setModesMultiplex(const int modes[], const uint8_t weights[], int size) {
+    setModesMultiplex(modes, size);
+
+    for (int i = 0; i < size; i++) {
+        setModeWeight(modes[i], weights[i]);
+    }
+}
+
+void HTL_onboard::setModeWeight(int mode, uint8_t weight) {
+    if (mode >= 0 && mode < 3) {
+        modeWeights[mode] = constrain(weight, 1, MAX_MODE_WEIGHT);
+    }
+}
+
+uint8_t HTL_onboard::getModeWeight(int mode) {
+    if (mode >= 0 && mode < 3) {
+        return modeWeights[mode];
+    }
+    return 0;
+}
+
+void HTL_onboard::setBrightness(uint8_t brightness) {
+    this->brightness = brightness;
+    storeRGBFrame();
+    if (stripeMode == STRIPE_MODE_GRAY) {
+        storeStripeFrame(); // The gray LED stripe is dimmed by its intensities
+    }
+    updateTimerDimming();
+}
+
+uint8_t HTL_onboard::getBrightness() {
+    return brightness;
+}
+
+void HTL_onboard::multiplexBlank() {
+    // The RGB LED is dimmed by its color
+    if (currentMode != MODE_RGB) {
+        blankDisplays();
+    }
+}
+
+void HTL_onboard::setMultiplexInterval(int multiplexInterval) {
+    if (multiplexInterval >= 0) {
+	this -> multiplexInterval = multiplexInterval;
     }
 }
 
 void HTL_onboard::setHexMode(int mode) {
-    if (mode >= 0 && mode <= 3) {
+    if (mode >= 0 && mode <= (HTL_PAGED_NUMBERS ? HEX_MODE_PAGED_HEX : HEX_MODE_STRING)) {
         HEX_mode = mode;
     }
 
+    // The paged modes keep the full number, the pages depend on the base
+    if (HEX_mode >= HEX_MODE_PAGED_DEC) {
+        showPagedNumber(true);
+        return;
+    }
+
     // Ensure that the hexNumber is valid for the new mode
     setHexNumber(hexNumber);
 }
@@ -552,28 +2412,134 @@ void HTL_onboard::setHexNumber(int number) {
         case HEX_MODE_STRING:
             strInx = 0;
             break;
+        case HEX_MODE_PAGED_DEC:
+        case HEX_MODE_PAGED_HEX:
+            hexNumber = number;
+            setPagedNumber(number);
+            return;
+    }
+
+    storeHexFrame();
+}
+
+void HTL_onboard::setPagedNumber(long number) {
+#if HTL_PAGED_NUMBERS
+    number = constrain(number, -32768L, 65535L);
+    bool negative = number < 0;
+    uint16_t magnitude = negative ? (uint16_t)-number : (uint16_t)number;
+    if (negative == pagedNegative && magnitude == pagedMagnitude) {
+        return; // Already encoded, or encoded when a paged mode is set
+    }
+
+    pagedNegative = negative;
+    pagedMagnitude = magnitude;
+    if (HEX_mode >= HEX_MODE_PAGED_DEC) {
+        showPagedNumber(false);
+    }
+#endif
+}
+
+long HTL_onboard::getPagedNumber() {
+#if HTL_PAGED_NUMBERS
+    return pagedNegative ? -(long)pagedMagnitude : (long)pagedMagnitude;
+#else
+    return 0;
+#endif
+}
+
+void HTL_onboard::showPagedNumber(bool now) {
+#if HTL_PAGED_NUMBERS
+    // The multiplexer keeps showing its buffer and does not swap while the other one is encoded
+    pagesPending = false;
+    uint8_t next = pageBuffer ^ 1;
+    pageCounts[next] = encodePages(pages[next], pagedNegative, pagedMagnitude, (HEX_mode == HEX_MODE_PAGED_HEX) ? 0x10 : 10);
+
+    uint8_t oldSREG = SREG;
+    cli();
+    if (now || pageCounts[pageBuffer] <= 1) {
+        pageBuffer = next;
+        pageInx = 0;
+        lastStringUpdateTime = millis();
+    } else {
+        pagesPending = true;
     }
+    SREG = oldSREG;
+
+    storeHexFrame();
+#endif
 }
 
 void HTL_onboard::setChar(char c) {
     setHexNumber((int)c);
 }
 
-void HTL_onboard::setString(String str) {
-    this->str = str;
+void HTL_onboard::setString(const char* str) {
+    storeString(str, false);
+}
+
+void HTL_onboard::setString(const __FlashStringHelper* str) {
+    storeString(reinterpret_cast<const char*>(str), true);
+}
+
+void HTL_onboard::setString(const String& str) {
+    storeString(str.c_str(), false);
+}
+
+void HTL_onboard::storeString(const char* str, bool inFlash) {
+    // Encoded into local buffers first, so the timer interrupt only waits for the copy
+    char chars[MAX_STRING_LENGTH + 1];
+    uint8_t segments[MAX_STRING_LENGTH];
+    uint8_t length = 0;
+    if (str) {
+        for (; length < MAX_STRING_LENGTH; length++) {
+            char c = inFlash ? (char)pgm_read_byte(str + length) : str[length];
+            if (c == '\0') {
+                break;
+            }
+            chars[length] = c;
+            segments[length] = charSegments(c);
+        }
+    }
+    chars[length] = '\0';
+    if (length == 0) {
+        segments[0] = 0; // An empty string shows nothing
+    }
+
+    // The timer interrupt may read the string while it is rewritten
+    uint8_t oldSREG = SREG;
+    cli();
+    memcpy(this->str, chars, length + 1);
+    memcpy(strSegments, segments, max(length, (uint8_t)1));
+    strLength = length;
+    if (strInx >= length) {
+        strInx = 0;
+    }
+    SREG = oldSREG;
+
+    storeHexFrame();
 }
 
-String HTL_onboard::getString() {
+const char* HTL_onboard::getString() {
     return str;
 }
 
+void HTL_onboard::setStringDelay(int stringDelay) {
+    if (stringDelay >= 0) {
+        strDelay = stringDelay;
+    }
+}
+
+int HTL_onboard::getStringDelay() {
+    return strDelay;
+}
+
 int HTL_onboard::getHexNumber() {
     return hexNumber;
 }
 
 
 void HTL_onboard::setStripeMode(int mode) {
-    if (mode >= 0 && mode <= 1) {
+    if (mode >= 0 && mode <= (HTL_GRAY_STRIPE ? STRIPE_MODE_GRAY : STRIPE_MODE_PROG)) {
         stripeMode = mode;
     }
 
@@ -593,23 +2559,58 @@ void HTL_onboard::setLedStripeValue(int value) {
         case STRIPE_MODE_PROG:
             ledStripeValue = constrain(value, 0, 10);
             break;
+        case STRIPE_MODE_GRAY:
+            ledStripeValue = constrain(value, 0, 1023); // Kept for the other modes
+            break;
     }
+
+    storeStripeFrame();
 }
 
 int HTL_onboard::getLedStripeValue() {
     return ledStripeValue;
 }
 
+void HTL_onboard::setStripeLevel(int led, uint8_t level) {
+#if HTL_GRAY_STRIPE
+    if (led < 0 || led > 9) {
+        return;
+    }
+    stripeLevels[led] = level;
+    storeStripeFrame();
+#endif
+}
+
+void HTL_onboard::setStripeLevels(const uint8_t levels[10]) {
+#if HTL_GRAY_STRIPE
+    for (uint8_t led = 0; led < 10; led++) {
+        stripeLevels[led] = levels[led];
+    }
+    storeStripeFrame();
+#endif
+}
+
+uint8_t HTL_onboard::getStripeLevel(int led) {
+#if HTL_GRAY_STRIPE
+    return (led >= 0 && led <= 9) ? stripeLevels[led] : 0;
+#else
+    return 0;
+#endif
+}
+
 void HTL_onboard::setRed(uint8_t r) {
     red = constrain(r, 0, 255);
+    storeRGBFrame();
 }
 
 void HTL_onboard::setGreen(uint8_t g) {
     green = constrain(g, 0, 255);
+    storeRGBFrame();
 }
 
 void HTL_onboard::setBlue(uint8_t b) {
     blue = constrain(b, 0, 255);
+    storeRGBFrame();
 }
 
 uint8_t HTL_onboard::getRed() {
@@ -30,14 +30,148 @@
 #define HEX_MODE_DEC 1
 #define HEX_MODE_CHAR 2
 #define HEX_MODE_STRING 3
+#define HEX_MODE_PAGED_DEC 4
+#define HEX_MODE_PAGED_HEX 5
 
 #define STRIPE_MODE_BIN 0
 #define STRIPE_MODE_PROG 1
+#define STRIPE_MODE_GRAY 2
 
-#define RGB_DELAY 1 // How long to keep the RGB Led on in milliseconds
+#ifndef STRIPE_GRAY_BITS
+#define STRIPE_GRAY_BITS 6 // Bits per LED in STRIPE_MODE_GRAY (4 to 8), each one is a bit plane in both frames
+#endif
+static_assert(STRIPE_GRAY_BITS >= 4 && STRIPE_GRAY_BITS <= 8, "STRIPE_GRAY_BITS must be 4 to 8");
+
+#define MAX_STRING_LENGTH 32 // Characters kept by setString(), longer strings are cut off
+#define PAGED_MAX_PAGES 11 // Pages of a paged number: 5 digits, blanks between equal digits and two at the end
+
+#ifndef HTL_FAST_IO
+#define HTL_FAST_IO 1 // Set to 0 to compile out the direct port-register output path
+#endif
+
+// Features that keep state in every object, 1 keeps their state and code. Set them here or as build
+// flags for all files, so that the library and the sketch agree on the class layout, see HTL_LAYOUT.
+#ifndef HTL_TASKS
+#define HTL_TASKS 0 // Set to 1 for addTask() and its timer wheel, about 130 bytes per object
+#endif
+#ifndef HTL_ANIMATIONS
+#define HTL_ANIMATIONS 0 // Set to 1 for animateRGB() and animateStripe(), about 180 bytes per object
+#endif
+#ifndef HTL_SWITCH_EVENTS
+#define HTL_SWITCH_EVENTS 1 // Debouncing, getSwitches() and the event queue of getSwitchEvent()
+#endif
+#ifndef HTL_POT_FILTER
+#define HTL_POT_FILTER 1 // The potentiometer filter of setPotOversampling() and the other setPot...() methods
+#endif
+#ifndef HTL_PAGED_NUMBERS
+#define HTL_PAGED_NUMBERS 1 // setPagedNumber() and the paged HEX modes
+#endif
+#ifndef HTL_GRAY_STRIPE
+#define HTL_GRAY_STRIPE 0 // Set to 1 for STRIPE_MODE_GRAY, its bit planes take about 60 bytes per object
+#endif
+
+#ifndef HTL_MULTIPLEX_STATS
+#define HTL_MULTIPLEX_STATS 0 // Set to 1 to record the multiplex timing, see getMultiplexStats()
+#endif
+
+// The library defines one symbol named after the switches that change the class layout, and the
+// constructor reads the one of the including file. A sketch built with other switches than the
+// library fails to link (undefined reference to htl_layout_...) instead of using a wrong layout.
+#define HTL_LAYOUT_NAME(io, stats, tasks, anim, events, pot, paged, gray, bits) \
+    htl_layout_##io##stats##tasks##anim##events##pot##paged##gray##_##bits
+#define HTL_LAYOUT_SYMBOL(...) HTL_LAYOUT_NAME(__VA_ARGS__)
+#define HTL_LAYOUT HTL_LAYOUT_SYMBOL(HTL_FAST_IO, HTL_MULTIPLEX_STATS, HTL_TASKS, HTL_ANIMATIONS, HTL_SWITCH_EVENTS, \
+                                     HTL_POT_FILTER, HTL_PAGED_NUMBERS, HTL_GRAY_STRIPE, STRIPE_GRAY_BITS)
+extern const volatile uint8_t HTL_LAYOUT;
+
+// Type of a memory-mapped output port register (PORTB, PORTD, ...)
+#ifndef HTL_PORT_T
+#define HTL_PORT_T volatile uint8_t
+#endif
+
+#define HTL_MAX_PORTS 2 // Number of output ports the data and select lines may be spread across
+
+#define RGB_DELAY 1 // How long to keep the RGB Led on in milliseconds, only used with RGB_MODE_PWM
                     // WARNING: SETTING THIS TO A HIGH VALUE MAY DECREASE MULTIPLEXING FREQUENCY AND CAUSE FLICKERING IN OTHER MODES!
                     // Maximum suggested value ~30
 
+#define RGB_MODE_PWM 0 // analogWrite() and delay(RGB_DELAY) in the RGB slot
+#define RGB_MODE_BAM 1 // Bit-angle modulation of the data lines spread across the RGB slot
+
+#define RGB_BAM_UNIT 4 // Length of the shortest bit-angle modulation step with updateMultiplex() in microseconds
+#define RGB_BAM_STEPS 6 // Bit planes 7 to 3, then one of the planes 2 to 0, also for the gray LED stripe
+
+#define MAX_MODE_WEIGHT 16 // Maximum number of consecutive slots of one mode
+
+#define ANALOG_POT 0 // Potentiometer on A0
+#define ANALOG_SWITCHES 1 // Switch ladder on A1
+#define SAMPLE_RATE_WINDOW 256 // Samples per input over which getSampleRate() is measured
+
+#define SWITCH_S2 0x01 // Switch bits in SwitchEvent::switches and getSwitches()
+#define SWITCH_S3 0x02
+
+#define SWITCH_EVENT_PRESS 1 // A switch was pressed
+#define SWITCH_EVENT_RELEASE 2 // A switch was released
+#define SWITCH_EVENT_LONG_PRESS 3 // The switches were held for SWITCH_LONG_PRESS_MS
+#define SWITCH_EVENT_BOTH 4 // Both switches are pressed
+
+#define SWITCH_DEBOUNCE_MS 20 // How long a switch state must be stable before it is accepted
+#define SWITCH_LONG_PRESS_MS 1000
+#define SWITCH_EVENT_QUEUE 8 // Size of the switch event queue, a power of two
+
+#ifndef SWITCH_CALIBRATION_ADDRESS
+#define SWITCH_CALIBRATION_ADDRESS 1008 // EEPROM address of the switch calibration (10 bytes), in the last 16 bytes
+#endif
+#define SWITCH_CALIBRATION_VERSION 1 // Layout of the stored calibration, older layouts are ignored
+#define SWITCH_CALIBRATION_SAMPLES 16 // A1 samples per sampleSwitchLevel(), one per millisecond
+#define SWITCH_CALIBRATION_SPREAD 24 // Largest difference between the samples of a stable level
+#define SWITCH_CALIBRATION_GAP 40 // Smallest difference between the levels of two switch states
+
+#define POT_MAX_EXTRA_BITS 2 // Oversampling gives up to 12 bit potentiometer values
+#define POT_MEDIAN_MAX 5 // Largest median window of the potentiometer filter
+#define POT_MAX_SMOOTHING 6 // Largest averaging shift of the potentiometer filter
+
+#define MAX_TASKS 8 // Size of the task table of addTask(), at most 8
+#define TASK_WHEEL_SIZE 16 // Buckets of the task timer wheel, one per millisecond, a power of two
+
+#define STATS_BINS 8 // Bins of the slot lateness histogram of MultiplexStats
+
+#define ANIMATION_TRACKS 8 // Size of the animation track table, shared by the LED stripe and the RGB LED
+
+#define ANIM_FADE 0 // RGB: fades from the current to the given color
+#define ANIM_GRADIENT 1 // RGB: red to green to blue to red in one period
+#define ANIM_BLINK 2 // RGB or LED stripe: the given color or value for half a period, then off
+#define ANIM_CHASE 3 // LED stripe: one LED runs from LED 0 to LED 9
+#define ANIM_BOUNCE 4 // LED stripe: one LED runs to LED 9 and back
+#define ANIM_PROGRESS 5 // LED stripe: a progress bar fills from 0 to 10 LEDs
+
+#define PROTOCOL_SOF 0xA5 // First byte of every frame of the serial protocol
+#define PROTOCOL_MAX_PAYLOAD 48 // Largest payload of a received frame
+#define PROTOCOL_MAX_REPLY 14 // Largest payload of a reply frame, e.g. 4 PROTOCOL_CMD_READ_INPUTS
+#define PROTOCOL_TIMEOUT_MS 50 // A frame whose next byte has not arrived this long is dropped
+
+#define PROTOCOL_CMD_HEX_NUMBER 0x01 // int16: setHexNumber()
+#define PROTOCOL_CMD_CHAR 0x02 // char: setChar()
+#define PROTOCOL_CMD_STRING 0x03 // length, characters: setString()
+#define PROTOCOL_CMD_STRIPE 0x04 // int16: setLedStripeValue()
+#define PROTOCOL_CMD_RGB 0x05 // red, green, blue: setRGB_Multiplex()
+#define PROTOCOL_CMD_MODES 0x06 // bit mask of the modes: setModesMultiplex()
+#define PROTOCOL_CMD_INTERVAL 0x07 // uint16: setMultiplexInterval()
+#define PROTOCOL_CMD_HEX_MODE 0x08 // mode: setHexMode()
+#define PROTOCOL_CMD_STRIPE_MODE 0x09 // mode: setStripeMode()
+#define PROTOCOL_CMD_READ_INPUTS 0x0A // no arguments, adds readPot() and readSwitchState() to the reply
+#define PROTOCOL_CMD_STREAM_STATS 0x0B // no arguments, adds the streamed, dropped and late frames to the reply
+
+#define PROTOCOL_OK 0 // Reply status: all commands of the frame were executed
+#define PROTOCOL_ERROR_CRC 1 // The checksum of the frame did not match, nothing was executed
+#define PROTOCOL_ERROR_COMMAND 2 // Unknown command, the commands before it were executed
+#define PROTOCOL_ERROR_LENGTH 3 // A command was cut off by the end of the frame or the reply is full
+
+#define PROTOCOL_STREAM_SOF 0x5A // First byte of a streamed display frame
+#define PROTOCOL_STREAM_SIZE 8 // Bytes of a streamed display frame between PROTOCOL_STREAM_SOF and the checksum
+#define PROTOCOL_STREAM_LATE_MS 4 // A streamed frame shown later than this after it was received counts as late
+#define PROTOCOL_STREAM_RESTART_MS 500 // After a pause this long the sequence numbers of a new stream start over
+
 // Define Pin Names for Breakout Pins(B)
 // B1 is Pin 1 of X17
 /*  
@@ -54,6 +188,36 @@
 #define B5 5
 #define B6 6
 
+/**
+ * @brief A debounced switch event, see getSwitchEvent().
+ */
+struct SwitchEvent {
+    uint8_t type; // SWITCH_EVENT_PRESS, SWITCH_EVENT_RELEASE, SWITCH_EVENT_LONG_PRESS or SWITCH_EVENT_BOTH
+    uint8_t switches; // SWITCH_S2 and/or SWITCH_S3
+    unsigned long time; // millis() when the event was detected
+};
+
+/**
+ * @brief A function run by the task scheduler, see addTask().
+ */
+typedef void (*TaskCallback)();
+
+/**
+ * @brief Timing of the multiplex slots, see getMultiplexStats(). Times are in microseconds.
+ */
+struct MultiplexStats {
+    unsigned long slots; // Slots since the last reset
+    unsigned int slotsPerSecond; // Slots in the last complete second
+    unsigned long minInterval; // Shortest time from the start of one slot to the next
+    unsigned long maxInterval;
+    unsigned long avgInterval; // Moving average over about 16 slots
+    unsigned long histogram[STATS_BINS]; // Slots by lateness: more than 64 early, < 64, < 128, ... < 2048, >= 2048 late
+    unsigned long lateSlots; // Slots that started more than a quarter interval late
+    unsigned long missedSlots; // Whole intervals that passed without a slot
+    unsigned long modeMicros[3]; // Time each display was shown, wraps after about 71 minutes
+    unsigned long maxLoopGap; // Longest time between two calls of updateMultiplex()
+};
+
 /**
  * @brief Library for controlling onboard hardware components including HEX display, LED stripe, and RGB LED.
  * 
@@ -67,7 +231,9 @@
  */
 class HTL_onboard {
 public:
-    HTL_onboard();
+    HTL_onboard() {
+        (void)HTL_LAYOUT; // A volatile read, so the reference is kept even with link-time optimization
+    }
 
     /**
      * @brief Initializes the HTL_onboard library.
@@ -162,6 +328,147 @@ public:
      */
     int readPot();
 
+    /**
+     * @brief Reads the filtered potentiometer value with the extra bits of oversampling.
+     * 
+     * @return unsigned int The potentiometer value (0 to 1023 << getPotOversampling()).
+     */
+    unsigned int readPotHighRes();
+
+    /**
+     * @brief Sets the number of extra bits gained by oversampling the potentiometer.
+     * 
+     * 4^bits samples are summed and shifted right by bits, so 2 extra bits (12 bit values) take
+     * 16 samples per filtered value. readPot() keeps returning 0 to 1023. The filter setters have
+     * no effect if HTL_POT_FILTER is 0.
+     * 
+     * @param bits The extra bits (0 to POT_MAX_EXTRA_BITS, default 0).
+     */
+    void setPotOversampling(uint8_t bits);
+
+    /**
+     * @brief Gets the number of extra bits gained by oversampling the potentiometer.
+     * 
+     * @return uint8_t The extra bits.
+     */
+    uint8_t getPotOversampling();
+
+    /**
+     * @brief Sets the size of the median filter of the potentiometer, which removes single spikes.
+     * 
+     * @param size The number of values the median is taken of (1 for off, 3 or 5).
+     */
+    void setPotMedian(uint8_t size);
+
+    /**
+     * @brief Gets the size of the median filter of the potentiometer.
+     * 
+     * @return uint8_t The number of values the median is taken of.
+     */
+    uint8_t getPotMedian();
+
+    /**
+     * @brief Sets the smoothing of the potentiometer with an exponential moving average.
+     * 
+     * Every filtered value moves the average by 1/2^shift of the difference.
+     * 
+     * @param shift The averaging shift (0 for off to POT_MAX_SMOOTHING).
+     */
+    void setPotSmoothing(uint8_t shift);
+
+    /**
+     * @brief Gets the smoothing of the potentiometer.
+     * 
+     * @return uint8_t The averaging shift.
+     */
+    uint8_t getPotSmoothing();
+
+    /**
+     * @brief Sets the hysteresis of the potentiometer.
+     * 
+     * The value only follows changes larger than the deadband and snaps to 0 and 1023 near
+     * the ends, so it does not flicker between two neighbouring values.
+     * 
+     * @param deadband The deadband in steps of readPot() (0 for off).
+     */
+    void setPotHysteresis(uint8_t deadband);
+
+    /**
+     * @brief Gets the hysteresis of the potentiometer.
+     * 
+     * @return uint8_t The deadband in steps of readPot().
+     */
+    uint8_t getPotHysteresis();
+
+    /**
+     * @brief Starts sampling the potentiometer and the switches from the ADC interrupt.
+     * 
+     * The ADC converts A0 and A1 alternately in the background (about 4800 samples per second
+     * each), and readPot() and readSwitchState() return the latest sample without waiting for a
+     * conversion. Do not use analogRead() while the sampler is running.
+     */
+    void beginAnalogSampler();
+
+    /**
+     * @brief Stops the background sampling, readPot() and readSwitchState() use analogRead() again.
+     */
+    void endAnalogSampler();
+
+    /**
+     * @brief Called by the ADC interrupt with a finished conversion, starts the next one.
+     */
+    void samplerTick();
+
+    /**
+     * @brief Gets the age of the latest sample of an input.
+     * 
+     * @param input The input (0 for the potentiometer, 1 for the switches).
+     * @return unsigned long Microseconds since the sample was taken, 0 if the sampler is not running.
+     */
+    unsigned long getSampleAge(int input);
+
+    /**
+     * @brief Gets the sample rate of an input.
+     * 
+     * @param input The input (0 for the potentiometer, 1 for the switches).
+     * @return unsigned int Samples per second, measured over SAMPLE_RATE_WINDOW samples. 0 if the sampler is not running.
+     */
+    unsigned int getSampleRate(int input);
+
+    /**
+     * @brief Takes the oldest switch event from the queue.
+     * 
+     * The switches are debounced with the thresholds of cfgSwitches() in the ADC interrupt, so
+     * beginAnalogSampler() must be running. Press and release events are reported per switch,
+     * SWITCH_EVENT_BOTH when both switches are down and SWITCH_EVENT_LONG_PRESS once when the
+     * switches are held for SWITCH_LONG_PRESS_MS.
+     * 
+     * @param event Receives the event.
+     * @return bool true if an event was taken, false if the queue is empty or HTL_SWITCH_EVENTS is 0.
+     */
+    bool getSwitchEvent(SwitchEvent& event);
+
+    /**
+     * @brief Gets the number of switch events waiting in the queue.
+     * 
+     * @return uint8_t The number of events.
+     */
+    uint8_t switchEventsAvailable();
+
+    /**
+     * @brief Gets the number of switch events lost because the queue was full.
+     * 
+     * @return unsigned int The number of lost events.
+     */
+    unsigned int getLostSwitchEvents();
+
+    /**
+     * @brief Gets the debounced switch state.
+     * 
+     * @return uint8_t SWITCH_S2 and/or SWITCH_S3 for the pressed switches, 0 if HTL_SWITCH_EVENTS is 0.
+     */
+    uint8_t getSwitches();
+
     /**
      * @brief Sets the mode of the HTL_onboard.
      * 
@@ -179,17 +486,135 @@ public:
      */
     void cfgSwitches(int switch1Threshold, int switchNoneThreshold, int switch12Threshold);
 
+    /**
+     * @brief Measures the voltage of the switch ladder on A1 for calibrateSwitches().
+     * 
+     * Takes SWITCH_CALIBRATION_SAMPLES samples one millisecond apart, so it blocks for about 16
+     * milliseconds. Hold the switches still while it runs.
+     * 
+     * @return int The average level (0 to 1023), -1 if the samples spread more than SWITCH_CALIBRATION_SPREAD.
+     */
+    int sampleSwitchLevel();
+
+    /**
+     * @brief Sets the switch thresholds between the measured levels of the board and stores them in EEPROM.
+     * 
+     * Each threshold is the midpoint between two neighbouring levels, so resistor tolerances of the
+     * ladder no longer shift a state across a fixed threshold. The thresholds are stored at
+     * SWITCH_CALIBRATION_ADDRESS with a version and a checksum, and begin() loads them again.
+     * 
+     * @param levels The levels of sampleSwitchLevel() for readSwitchState() 0 (none), 1 (both), 2 (S2) and 3 (S3).
+     * @return bool false if the levels are not in the order S3 < both < S2 < none with SWITCH_CALIBRATION_GAP between them.
+     */
+    bool calibrateSwitches(const int levels[4]);
+
+    /**
+     * @brief Loads the switch thresholds stored by calibrateSwitches(). Called by begin().
+     * 
+     * @return bool true if a calibration with a valid version and checksum was found, false if the thresholds are unchanged.
+     */
+    bool loadSwitchCalibration();
+
+    /**
+     * @brief Erases the stored switch calibration and restores the default thresholds.
+     */
+    void clearSwitchCalibration();
+
    /**
     * @brief Updates all displays. Call this function in loop()
     */
     void updateMultiplex();
 
+   /**
+    * @brief Starts refreshing the displays from the Timer2 compare interrupt.
+    *
+    * The interrupt drives one multiplex slot per period, independent of loop(). updateMultiplex()
+    * does nothing while the timer is running. The RGB slot lasts one period with RGB_MODE_PWM, with
+    * RGB_MODE_BAM it lasts 256 timer ticks at a prescaler of at least 32 (at least 512 microseconds),
+    * like the LED stripe slot with STRIPE_MODE_GRAY.
+    * Use the setters (setHexNumber(), setLedStripeValue(), ...) to change the displayed values.
+    * Timer2 is no longer available for tone() or analogWrite() on pins 3 and 11.
+    *
+    * @param slotRate Number of multiplex slots per second (62 to 20000).
+    */
+    void beginTimerMultiplex(unsigned int slotRate = 1000);
+
+   /**
+    * @brief Stops the Timer2 interrupt and returns to polled multiplexing with updateMultiplex().
+    *
+    * All displays are turned off until the next slot, and Timer2 gets the setup of the Arduino core
+    * back, so analogWrite() on pins 3 and 11 and tone() work again.
+    */
+    void endTimerMultiplex();
+
+   /**
+    * @brief Drives the next multiplex slot immediately.
+    *
+    * Called by the timer interrupt in timer multiplex mode. It never blocks, so it can also be
+    * called from an own timer interrupt if Timer2 is used otherwise.
+    */
+    void multiplexTick();
+
+   /**
+    * @brief Turns off the HEX display and LED stripe for the rest of the slot.
+    *
+    * Called by the Timer2 compare B interrupt when the brightness is below 255.
+    */
+    void multiplexBlank();
+
    /**
     * @brief Sets the modes which are used to display in multiplex operation.
     *
+    * Every mode gets one slot per round again, weights of an earlier call are reset.
+    *
     * @param modes array of modes that are displayed in Multiplex mode. (0 for HEX, 1 for LED stripe, 2 for RGB)
     */
     void setModesMultiplex(const int modes[], int size);
+
+   /**
+    * @brief Sets the modes which are used to display in multiplex operation and their weights.
+    *
+    * A mode with weight n is shown for n consecutive slots before the next mode follows, so
+    * {MODE_HEX, MODE_RGB} with weights {3, 1} gives the HEX display 75% of the time.
+    *
+    * @param modes array of modes that are displayed in Multiplex mode. (0 for HEX, 1 for LED stripe, 2 for RGB)
+    * @param weights array of slot counts for the modes (1 to MAX_MODE_WEIGHT).
+    */
+    void setModesMultiplex(const int modes[], const uint8_t weights[], int size);
+
+   /**
+    * @brief Sets the number of consecutive slots of a mode in multiplex operation.
+    *
+    * @param mode The mode (0 for HEX, 1 for LED stripe, 2 for RGB).
+    * @param weight The number of slots (1 to MAX_MODE_WEIGHT, default 1).
+    */
+    void setModeWeight(int mode, uint8_t weight);
+
+   /**
+    * @brief Gets the number of consecutive slots of a mode in multiplex operation.
+    *
+    * @param mode The mode (0 for HEX, 1 for LED stripe, 2 for RGB).
+    * @return uint8_t The number of slots.
+    */
+    uint8_t getModeWeight(int mode);
+
+   /**
+    * @brief Sets the brightness of all displays in multiplex operation.
+    *
+    * The HEX display and LED stripe are turned off after brightness/255 of each slot,
+    * the color of the RGB LED is scaled. Polled multiplexing needs an interval of at
+    * least 1 ms for dimming.
+    *
+    * @param brightness The brightness (0 to 255, default 255).
+    */
+    void setBrightness(uint8_t brightness);
+
+   /**
+    * @brief Gets the brightness of all displays in multiplex operation.
+    *
+    * @return uint8_t The brightness (0 to 255).
+    */
+    uint8_t getBrightness();
     
     /**
     * @brief Sets the interval for multiplexing between different display modes.
@@ -206,28 +631,49 @@ public:
     /**
      * @brief Sets the display mode of the HEX display.
      * 
-     * @param mode The mode to set (0 for HEX, 1 for Decimal, 2 for Character).
+     * @param mode The mode to set (0 for HEX, 1 for Decimal, 2 for Character, 3 for String, 4 for paged Decimal, 5 for paged HEX).
+     *             The paged modes are ignored if HTL_PAGED_NUMBERS is 0.
      */
     void setHexMode(int mode);
 
     /**
      * @brief Gets the current display mode of the HEX display.
      * 
-     * @return int The current display mode (0 for HEX, 1 for Decimal, 2 for Character, 3 for String).
+     * @return int The current display mode (0 for HEX, 1 for Decimal, 2 for Character, 3 for String, 4 for paged Decimal, 5 for paged HEX).
      */
     int getHexMode();
 
     /**
      * @brief Sets the number to be displayed on the HEX display.
      * 
-     * @param number The number to display (-15 to 15 in HEX mode, -19 to 19 in Decimal mode).
+     * @param number The number to display (-15 to 15 in HEX mode, -19 to 19 in Decimal mode, any int in the paged modes).
      */
     void setHexNumber(int number);
 
+    /**
+     * @brief Sets the number to be displayed in HEX_MODE_PAGED_DEC and HEX_MODE_PAGED_HEX.
+     * 
+     * The number is shown digit by digit, each digit for strDelay (ms), and the minus line stays lit
+     * between the digits of a negative number. A blank page separates equal digits and two blank pages end
+     * the number; a single digit is shown without paging. The pages are encoded once when the number changes. A new number starts
+     * with the next round of pages, so the display never mixes the digits of two numbers. getHexNumber() is not changed.
+     * 
+     * @param number The number to display (-32768 to 65535, int16_t and uint16_t values).
+     */
+    void setPagedNumber(long number);
+
+    /**
+     * @brief Gets the number of the paged modes.
+     * 
+     * @return long The number set by setPagedNumber() or by setHexNumber() in a paged mode (-32768 to 65535).
+     */
+    long getPagedNumber();
+
     /**
      * @brief Gets the number/character currently displayed on the HEX display.
      * 
-     * @return int The number/character displayed on the HEX display as int.
+     * @return int The number/character displayed on the HEX display as int. In the paged modes the last
+     *             value of setHexNumber(), see getPagedNumber() for the number that is shown.
      */
     int getHexNumber();
 
@@ -244,28 +690,45 @@ public:
      * The string gets displayed character by character, with each character being displayed for strDelay (ms).
      * Displaying strings is only supported for Multiplex mode, for Hex_mode only use setChar or only activate HEX mode
      * 
+     * The characters are copied into a buffer of MAX_STRING_LENGTH and encoded to segments once, so the
+     * string does not need to stay valid and no heap is used.
+     * 
+     * @param str The string to display (ASCII).
+     */
+    void setString(const char* str);
+
+    /**
+     * @brief Sets the string to be displayed on the HEX display from flash, e.g. setString(F("HTL Uno")).
+     * 
+     * @param str The string in program memory.
+     */
+    void setString(const __FlashStringHelper* str);
+
+    /**
+     * @brief Sets the string to be displayed on the HEX display.
+     * 
      * @param str The string to display (ASCII).
      */
-    void setString(String str);
+    void setString(const String& str);
 
     /**
      * @brief Gets the string to be displayed on the HEX display.
      * 
-     * @return String The string being displayed.
+     * @return const char* The string being displayed, at most MAX_STRING_LENGTH characters.
      */
-    String getString();
+    const char* getString();
 
     /**
      * @brief Sets the display mode of the LED Stripe.
      * 
-     * @param mode The mode to set (0 for Binary, 1 for Progress).
+     * @param mode The mode to set (0 for Binary, 1 for Progress, 2 for Gray). Gray is ignored if HTL_GRAY_STRIPE is 0.
      */
     void setStripeMode(int mode);
 
     /**
      * @brief Gets the current display mode of the LED Stripe.
      * 
-     * @return int The current display mode (0 for Binary, 1 for Progress).
+     * @return int The current display mode (0 for Binary, 1 for Progress, 2 for Gray).
      */
     int getStripeMode();
 
@@ -279,6 +742,98 @@ public:
      */
     void setRGB_Multiplex(uint8_t red, uint8_t green, uint8_t blue);
 
+    /**
+     * @brief Sets the RGB LED to a color given as hue, saturation and value.
+     * 
+     * @param hue The hue in degrees (0 red, 120 green, 240 blue, wraps at 360).
+     * @param saturation The saturation (0 white to 255 full color).
+     * @param value The value (0 off to 255 full brightness).
+     */
+    void setHSV(uint16_t hue, uint8_t saturation, uint8_t value);
+
+    /**
+     * @brief Sets the color used in Multiplex mode as hue, saturation and value, see setHSV().
+     */
+    void setHSV_Multiplex(uint16_t hue, uint8_t saturation, uint8_t value);
+
+    /**
+     * @brief Sets the RGB LED to a color given as hue, saturation and lightness.
+     * 
+     * @param hue The hue in degrees (0 red, 120 green, 240 blue, wraps at 360).
+     * @param saturation The saturation (0 gray to 255 full color).
+     * @param lightness The lightness (0 black, 128 full color, 255 white).
+     */
+    void setHSL(uint16_t hue, uint8_t saturation, uint8_t lightness);
+
+    /**
+     * @brief Sets the color used in Multiplex mode as hue, saturation and lightness, see setHSL().
+     */
+    void setHSL_Multiplex(uint16_t hue, uint8_t saturation, uint8_t lightness);
+
+    /**
+     * @brief Converts hue, saturation and value into red, green and blue with integer arithmetic.
+     */
+    static void hsvToRGB(uint16_t hue, uint8_t saturation, uint8_t value, uint8_t& red, uint8_t& green, uint8_t& blue);
+
+    /**
+     * @brief Converts hue, saturation and lightness into red, green and blue with integer arithmetic.
+     */
+    static void hslToRGB(uint16_t hue, uint8_t saturation, uint8_t lightness, uint8_t& red, uint8_t& green, uint8_t& blue);
+
+    /**
+     * @brief Enables or disables the gamma correction of the RGB LED.
+     * 
+     * With gamma correction (2.2, from a table in flash) equal steps of a color look like equal
+     * steps of brightness, so fades and gradients look even. The color getters keep returning
+     * the uncorrected values.
+     * 
+     * @param enabled true to correct the colors, false to output them linearly (default).
+     */
+    void setGammaCorrection(bool enabled);
+
+    /**
+     * @brief Gets whether the gamma correction of the RGB LED is enabled.
+     * 
+     * @return bool true if the colors are gamma corrected.
+     */
+    bool getGammaCorrection();
+
+    /**
+     * @brief Sets the white balance of the RGB LED, the maximum of each channel.
+     * 
+     * Every channel is scaled by its factor after the gamma correction, so white (255, 255, 255)
+     * can be tuned to look neutral on the LED.
+     * 
+     * @param red The maximum of red (0 to 255, default 255).
+     * @param green The maximum of green.
+     * @param blue The maximum of blue.
+     */
+    void setWhiteBalance(uint8_t red, uint8_t green, uint8_t blue);
+
+    /**
+     * @brief Gets the white balance of the RGB LED.
+     */
+    void getWhiteBalance(uint8_t& red, uint8_t& green, uint8_t& blue);
+
+    /**
+     * @brief Sets how the RGB LED is driven in Multiplex mode.
+     * 
+     * RGB_MODE_BAM (default) shows the color with bit-angle modulation: every bit plane of the
+     * 8 bit color is held for a time proportional to its weight, spread across the RGB slot by
+     * the multiplexer. It does not block and does not use the PWM timers. RGB_MODE_PWM uses
+     * analogWrite() and keeps the RGB LED on for RGB_DELAY milliseconds.
+     * 
+     * @param mode The RGB mode (0 for PWM, 1 for BAM).
+     */
+    void setRGBMode(int mode);
+
+    /**
+     * @brief Gets how the RGB LED is driven in Multiplex mode.
+     * 
+     * @return int The RGB mode (0 for PWM, 1 for BAM).
+     */
+    int getRGBMode();
+
     /**
      * @brief Sets the intensity of the red component of the RGB LED.
      * 
@@ -322,7 +877,7 @@ public:
     uint8_t getBlue();
 
     /**
-     * @brief Sets the delay of how long to display a character in string display mode.
+     * @brief Sets the delay of how long to display a character in string display mode, or a digit in the paged modes.
      * 
      * @param ms The delay in ms.
      */
@@ -349,37 +904,1059 @@ public:
      */
     int getLedStripeValue();
 
-private:
     /**
-     * @brief Sets the pins of the LED-Stripe based on the provided value.
+     * @brief Sets the intensity of one LED of the LED stripe, shown in STRIPE_MODE_GRAY.
+     * 
+     * STRIPE_MODE_GRAY shows the intensities with bit-angle modulation in the stripe slot, with the
+     * same steps and timing as the RGB LED in RGB_MODE_BAM. The intensities pass through the
+     * brightness and gamma correction and are kept with STRIPE_GRAY_BITS bits. The bit planes are
+     * encoded once per change, so a step of the slot only writes precomputed port values. Set
+     * several LEDs between beginFrame() and commitFrame() to encode them once.
      * 
-     * @param value The value to set the pins to.
+     * @param led The LED (0 to 9).
+     * @param level The intensity (0 to 255).
      */
-    void setPins(uint8_t value);
+    void setStripeLevel(int led, uint8_t level);
 
-    const uint8_t pinMapping[10] = {0, 1, 2, 3, 4, 5, 6, 8, 7, 9}; // abcdefgNhi
-    const uint8_t pinMappingStripe[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
-    const uint8_t selectPins[3] = {10, 11, 12}; // HEX-Panel, LED-Stripe, RGB-LED
+    /**
+     * @brief Sets the intensities of all LEDs of the LED stripe, shown in STRIPE_MODE_GRAY.
+     * 
+     * @param levels The intensities of LED 0 to 9 (0 to 255).
+     */
+    void setStripeLevels(const uint8_t levels[10]);
 
-    // Note that switch 1 is S2 and switch 2 is S3
-    int switch1Threshold = 700;
-    int switchNoneThreshold = 900;
-    int switch12Threshold = 500;
+    /**
+     * @brief Gets the intensity of one LED of the LED stripe.
+     * 
+     * @param led The LED (0 to 9).
+     * @return uint8_t The intensity set by setStripeLevel() (0 to 255), 0 for an invalid LED.
+     */
+    uint8_t getStripeLevel(int led);
 
-    unsigned long lastMultiplexTime = 0;
-    int currentMode = 0; // Start with HEX display
-    bool modesActive[3] = {false, false, false}; // Track active modes
-    int multiplexInterval = 1;
+    /**
+     * @brief Queues an animation of the RGB LED.
+     * 
+     * The animation is advanced by the multiplex slots and never blocks. Animations of the RGB LED
+     * run one after another; one with repeat 0 runs until stopAnimations() is called.
+     * 
+     * @param effect ANIM_FADE, ANIM_GRADIENT or ANIM_BLINK.
+     * @param duration The length of one period in milliseconds.
+     * @param red The red component of the target (fade) or blink color.
+     * @param green The green component.
+     * @param blue The blue component.
+     * @param repeat The number of periods, 0 to repeat forever. A fade always runs once.
+     * @return bool false if the effect is unknown, all ANIMATION_TRACKS tracks are in use or HTL_ANIMATIONS is 0.
+     */
+    bool animateRGB(uint8_t effect, unsigned int duration, uint8_t red, uint8_t green, uint8_t blue, uint8_t repeat = 1);
 
-    int HEX_mode = 0; // 0: display as HEX, 1: display as Decimal, 2: display as character, 3: display as String
-    int hexNumber = 0; // Variable to hold the current number for HEX display
-    int stripeMode = 0; //0: display as binary, 1: display as progress
-    int ledStripeValue = 0; // Variable for LED stripe
-    String str = "";
+    /**
+     * @brief Queues an animation of the LED stripe, shown in STRIPE_MODE_BIN.
+     * 
+     * When the last stripe animation ends or is stopped, the stripe mode and value from before the
+     * first one started are shown again, also STRIPE_MODE_PROG or STRIPE_MODE_GRAY.
+     * 
+     * @param effect ANIM_BLINK, ANIM_CHASE, ANIM_BOUNCE or ANIM_PROGRESS.
+     * @param duration The length of one period in milliseconds.
+     * @param value The LEDs that blink (binary, default all), ignored by the other effects.
+     * @param repeat The number of periods, 0 to repeat forever.
+     * @return bool false if the effect is unknown, all ANIMATION_TRACKS tracks are in use or HTL_ANIMATIONS is 0.
+     */
+    bool animateStripe(uint8_t effect, unsigned int duration, int value = 0x3FF, uint8_t repeat = 1);
+
+    /**
+     * @brief Stops and removes all animations of a display. The RGB LED keeps its current color,
+     * the LED stripe returns to its mode and value from before the animations.
+     * 
+     * @param mode MODE_STRIPE or MODE_RGB.
+     */
+    void stopAnimations(int mode);
+
+    /**
+     * @brief Gets the number of running and queued animations of a display.
+     * 
+     * @param mode MODE_STRIPE or MODE_RGB.
+     * @return uint8_t The number of animations.
+     */
+    uint8_t getAnimations(int mode);
+
+    /**
+     * @brief Advances the animations to the current time.
+     * 
+     * Called at the start of every multiplex slot, so it only needs to be called by the sketch
+     * if the displays are not multiplexed.
+     */
+    void updateAnimations();
+
+    /**
+     * @brief Runs a function periodically or once, scheduled on the millis() clock of the multiplexer.
+     * 
+     * Replaces the millis() comparisons in loop(). Due tasks are run by updateMultiplex() after
+     * the display slot, one after another in the order of their numbers, and never block each other.
+     * With updateMultiplex() a task only runs if its longest run so far fits into the time left
+     * until the next slot, otherwise it waits for the next gap. A task longer than a whole slot
+     * runs in the first half of a slot. With beginTimerMultiplex() the interrupt keeps the slots
+     * on time, so due tasks run at once.
+     * 
+     * @param callback The function to run.
+     * @param period The time between two runs (and until the first run) in milliseconds, at least 1.
+     * @param repeat The number of runs, 0 to run until removeTask() is called.
+     * @return int The number of the task, -1 if all MAX_TASKS tasks are in use or HTL_TASKS is 0.
+     */
+    int addTask(TaskCallback callback, unsigned int period, uint8_t repeat = 0);
+
+    /**
+     * @brief Stops a task. It may also be called by the task itself.
+     * 
+     * @param task The number returned by addTask().
+     */
+    void removeTask(int task);
+
+    /**
+     * @brief Gets the longest run of a task so far, used to fit it between the multiplex slots.
+     * 
+     * @param task The number returned by addTask().
+     * @return unsigned int The time in microseconds, 0 if the task has not run yet.
+     */
+    unsigned int getTaskTime(int task);
+
+    /**
+     * @brief Runs the due tasks.
+     * 
+     * Called by updateMultiplex(), so it only needs to be called by the sketch if the displays are
+     * not multiplexed.
+     */
+    void updateTasks();
+
+    /**
+     * @brief Stores already encoded content of all three displays as one frame.
+     * 
+     * The content goes straight into the back frame, without the encoding of setHexNumber(),
+     * setLedStripeValue() and the other setters, and is shown from the next multiplex slot on.
+     * All three displays change in the same slot. The color passes through the brightness,
+     * gamma correction and white balance like with setRGB_Multiplex(). A scrolling string or a
+     * running animation overwrites its display again.
+     * 
+     * @param segments The segments of the HEX display (abcdefg, g is the LSB).
+     * @param negative Lights the minus sign of the HEX display.
+     * @param tens Lights the tens digit of the HEX display.
+     * @param stripe The LEDs of the LED stripe, bit 0 is LED 0.
+     * @param red The red value of the RGB LED.
+     * @param green The green value of the RGB LED.
+     * @param blue The blue value of the RGB LED.
+     * @return bool true if the frame of the previous call was replaced before it was shown.
+     */
+    bool storeRawFrame(uint8_t segments, bool negative, bool tens, uint16_t stripe, uint8_t red, uint8_t green, uint8_t blue);
+
+    /**
+     * @brief Checks whether the frame of the last storeRawFrame() waits for the next multiplex slot.
+     * 
+     * Unlike framePending(), changes of the setters, scrolling strings and animations do not count,
+     * only the swap that brings the raw frame to the front.
+     * 
+     * @param shownTime Set to millis() of that swap once the frame is shown.
+     * @return bool true until the frame is shown.
+     */
+    bool rawFramePending(unsigned long& shownTime);
+
+    /**
+     * @brief Starts a batch of setter calls that is shown as one frame.
+     * 
+     * Until commitFrame(), the multiplexer keeps showing the current frame, also in timer mode, and
+     * the setters only note which displays changed. commitFrame() encodes each changed display once
+     * and publishes all of them at the next slot boundary, so no slot shows a half-applied state,
+     * e.g. a new stripe mode with the old value. Calls may be nested, the outermost commitFrame()
+     * publishes. Scrolling strings, paged numbers and animations keep running but only show with
+     * the commit, so keep a batch short.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Ends a batch of setter calls started by beginFrame() and publishes the changes.
+     */
+    void commitFrame();
+
+    /**
+     * @brief Checks whether changed display content waits for the next multiplex slot.
+     * 
+     * @return bool true until the frame with the changes is shown, also while a batch is open.
+     */
+    bool framePending();
+
+    /**
+     * @brief Copies the multiplex timing recorded since the last reset.
+     * 
+     * The timing is only recorded if HTL_MULTIPLEX_STATS is set to 1. A slot interval is the time
+     * from the start of one slot to the next; lateness is how much longer it was than the set
+     * interval (multiplexInterval, or the slot period of beginTimerMultiplex()). A bit-angle
+     * modulated slot (RGB_MODE_BAM, STRIPE_MODE_GRAY) has its own length, so the slot after it
+     * may start early or late.
+     * 
+     * @param stats Receives the timing.
+     * @return bool false if the timing is compiled out.
+     */
+    bool getMultiplexStats(MultiplexStats& stats);
+
+    /**
+     * @brief Clears the recorded multiplex timing.
+     */
+    void resetMultiplexStats();
+
+    /**
+     * @brief Prints the recorded multiplex timing in three lines, e.g. to Serial.
+     * 
+     * @param out The output, e.g. Serial.
+     */
+    void printMultiplexStats(Print& out);
+
+    /**
+     * @brief Puts the MCU into idle sleep until the next interrupt. Call it at the end of loop().
+     * 
+     * The timers, the ADC and the UART keep running in idle sleep, so the CPU wakes up for the next
+     * slot of beginTimerMultiplex(), a sample of beginAnalogSampler(), a received byte, a pin of
+     * setWakePin() or the millis() tick every 1024 microseconds. With updateMultiplex() the slots
+     * therefore start on the millis() tick. While a polled slot needs microsecond timing (a bit-angle
+     * modulated RGB or gray stripe slot, or a brightness below 255) idle() returns without sleeping; use
+     * beginTimerMultiplex() to sleep during those slots as well.
+     */
+    void idle();
+
+    /**
+     * @brief Gets the share of the time spent in idle() since the last resetSleepStats().
+     * 
+     * The interrupt that ends a sleep is counted as sleep time.
+     * 
+     * @return uint8_t The sleep time in percent (0 to 100).
+     */
+    uint8_t getSleepPercent();
+
+    /**
+     * @brief Gets the time spent in idle() since the last resetSleepStats().
+     * 
+     * @return unsigned long The sleep time in microseconds, wraps after about 71 minutes.
+     */
+    unsigned long getSleepTime();
+
+    /**
+     * @brief Gets the number of times idle() put the MCU to sleep since the last resetSleepStats().
+     * 
+     * @return unsigned long The number of wakeups.
+     */
+    unsigned long getWakeups();
+
+    /**
+     * @brief Clears the sleep time and wakeups and starts a new measurement.
+     */
+    void resetSleepStats();
+
+    /**
+     * @brief Lets a level change of a pin wake the MCU from idle().
+     * 
+     * The pin change interrupt only ends the sleep, the sketch reads the pin itself. Use a pin the
+     * displays do not drive (13 or A2 to A5), the data lines change with every slot.
+     * 
+     * @param pin The pin to watch.
+     * @param enabled false to stop watching the pin.
+     */
+    void setWakePin(uint8_t pin, bool enabled = true);
+
+    /**
+     * @brief Enables or disables the direct port-register output path.
+     * 
+     * When enabled, every display frame is written with a few masked port stores instead of
+     * one pinMode()/digitalWrite() per pin. If the pins of the board cannot be mapped onto
+     * HTL_MAX_PORTS ports, the per-pin path stays active.
+     * 
+     * @param enabled true to write frames to the port registers, false to use digitalWrite().
+     */
+    void setFastOutput(bool enabled);
+
+    /**
+     * @brief Gets whether frames are written directly to the port registers.
+     * 
+     * @return bool true if the port-register path is active, false if the per-pin path is used.
+     */
+    bool getFastOutput();
+
+    /**
+     * @brief Gets the number of pin/port writes used to output the last multiplex slot.
+     * 
+     * Every digitalWrite()/pinMode() call of the per-pin path and every port store of the
+     * port-register path counts as one write.
+     * 
+     * @return int The number of writes of the last slot.
+     */
+    int getWritesPerFrame();
+
+private:
+    template <class Config> friend class HTL_onboardT;
+
+    struct Frame; // Encoded content of the displays, see frames
+
+    /**
+     * @brief Sets up the pins and port masks and deselects all displays, without encoding frames.
+     */
+    void beginPins();
+
+    /**
+     * @brief Outputs a frame of data lines and selects the given display.
+     * 
+     * Bit i of lines switches on the LED connected to line i of the mapping
+     * (pinMapping for the HEX display, pinMappingStripe for the LED stripe).
+     * 
+     * @param mode The display to select (0 for HEX, 1 for LED stripe, 2 for RGB).
+     * @param lines The data lines to switch on.
+     */
+    void writeLines(int mode, uint16_t lines);
+
+    /**
+     * @brief Encodes the HEX display content from HEX_mode and hexNumber.
+     * 
+     * @return uint16_t The data lines to switch on, 0 if the value is out of range.
+     */
+    uint16_t hexFrame();
+
+    /**
+     * @brief Encodes the LED stripe content from stripeMode and ledStripeValue.
+     * 
+     * @return uint16_t The data lines to switch on, 0 if the value is out of range.
+     */
+    uint16_t stripeFrame();
+
+    /**
+     * @brief Copies and encodes a string for setString(), reading it from flash if inFlash is set.
+     */
+    void storeString(const char* str, bool inFlash);
+
+    /**
+     * @brief Stores the encoded HEX display content in the back frame.
+     * 
+     * @return uint16_t The data lines that were stored.
+     */
+    uint16_t storeHexFrame();
+
+    /**
+     * @brief Stores the encoded LED stripe content in the back frame.
+     * 
+     * @return uint16_t The data lines that were stored.
+     */
+    uint16_t storeStripeFrame();
+
+    /**
+     * @brief Stores the RGB LED color in the back frame.
+     */
+    void storeRGBFrame();
+
+    /**
+     * @brief Stores data lines (and their port values) for a display in the back frame and marks it dirty.
+     * 
+     * @param mode The display (0 for HEX, 1 for LED stripe).
+     * @param lines The data lines to switch on.
+     */
+    void storeFrame(int mode, uint16_t lines);
+
+    /**
+     * @brief Encodes data lines (and their port values) for a display into a frame that is not shown.
+     * 
+     * @param mode The display (0 for HEX, 1 for LED stripe).
+     * @param lines The data lines to switch on.
+     * @param encoded Receives the lines.
+     */
+    void encodeLines(int mode, uint16_t lines, Frame& encoded);
+
+    /**
+     * @brief Encodes a color with its corrections and bit planes into a frame that is not shown.
+     */
+    void encodeRGB(uint8_t red, uint8_t green, uint8_t blue, Frame& encoded);
+
+    /**
+     * @brief Copies the encoded displays into the back frame and marks them dirty, with interrupts off.
+     * 
+     * @param encoded The frame filled by encodeLines(), encodeRGB(), ...
+     * @param modes Bit per display to copy (1 << MODE_HEX, ...).
+     */
+    void publishFrame(const Frame& encoded, uint8_t modes);
+
+    /**
+     * @brief Re-encodes all three displays, e.g. after the port masks changed.
+     */
+    void storeFrames();
+
+    /**
+     * @brief Makes the back frame the shown frame if any display changed and no batch is open.
+     */
+    void swapFrames();
+
+    /**
+     * @brief Notes a changed display while a batch of beginFrame() is open.
+     * 
+     * @return bool true if the display is encoded by commitFrame(), false if it has to be encoded now.
+     */
+    bool stageFrame(int mode);
+
+    /**
+     * @brief Outputs the cached content of the front frame for a display.
+     * 
+     * @param mode The display to output (0 for HEX, 1 for LED stripe, 2 for RGB).
+     */
+    void outputFrame(int mode);
+
+    /**
+     * @brief Outputs the cached data lines of the front frame for the HEX display or LED stripe.
+     */
+    void outputLinesFrame(int mode);
+
+    /**
+     * @brief Picks the display of the next slot, each active display keeps its weight in consecutive slots.
+     * 
+     * @param active The active displays, indexed by mode.
+     * @return int The display of the next slot.
+     */
+    int nextSlotMode(const bool active[3]);
+
+    /**
+     * @brief Queues an animation track, see animateRGB() and animateStripe().
+     */
+    bool queueAnimation(uint8_t target, uint8_t effect, unsigned int duration, const uint8_t color[3], int value, uint8_t repeat);
+
+#if HTL_ANIMATIONS
+    /**
+     * @brief Computes and shows the frame of the first animation of a display at the given phase (0 to 255).
+     */
+    void showAnimation(uint8_t track, uint8_t phase);
+
+    /**
+     * @brief Removes an animation from the track table, the following tracks move up.
+     */
+    void removeAnimation(uint8_t track);
+
+    /**
+     * @brief Shows the stripe mode and value again that were set before the stripe animations started.
+     */
+    void restoreStripe();
+#endif
+
+    /**
+     * @brief Updates the displays without the tasks, the part of updateMultiplex() before updateTasks().
+     */
+    void pollMultiplex();
+
+#if HTL_TASKS
+    /**
+     * @brief Puts a task into the timer wheel bucket of its due time.
+     */
+    void scheduleTask(uint8_t task);
+#endif
+
+    /**
+     * @brief Checks whether a task of the given length fits before the next polled multiplex slot.
+     */
+    bool taskFits(unsigned int runMicros);
+
+    /**
+     * @brief Moves to the next character of the string or page of the paged number once strDelay is over.
+     */
+    void advanceString();
+
+    /**
+     * @brief Encodes the paged number into the page buffer that is not shown and shows it at once if now
+     * is set or the current number has a single page, otherwise with the next round of pages.
+     */
+    void showPagedNumber(bool now);
+
+    /**
+     * @brief Publishes changed frames and blanks all displays at the start of a slot.
+     */
+    void startSlot();
+
+    /**
+     * @brief Starts the RGB slot with bit-angle modulation or analogWrite(), depending on rgbMode.
+     */
+    void outputRGBSlot();
+
+    /**
+     * @brief Records the shown display, the slot start for dimming and the writes of the slot.
+     */
+    void finishSlot(int mode, uint16_t slotStartWrites);
+
+#if HTL_MULTIPLEX_STATS
+    /**
+     * @brief Adds the slot that ends now to the timing, called by startSlot().
+     */
+    void recordSlot();
+
+    /**
+     * @brief Measures the time since the last call of updateMultiplex().
+     */
+    void recordLoopGap();
+#endif
+
+    /**
+     * @brief Selects the RGB LED and drives it with the given color without storing it.
+     */
+    void writeRGB(uint8_t red, uint8_t green, uint8_t blue);
+
+    /**
+     * @brief Applies the brightness (if scaled is set), the gamma correction and the white balance to a color.
+     */
+    void correctColor(uint8_t rgb[3], bool scaled);
+
+    /**
+     * @brief Starts a bit-angle modulated slot with its first bit plane.
+     * 
+     * @param mode The display (1 for the gray LED stripe, 2 for RGB).
+     */
+    void beginBAMSlot(int mode);
+
+    /**
+     * @brief Shows the next bit plane of the bit-angle modulated slot and schedules its end.
+     */
+    void outputBAMStep();
+
+    /**
+     * @brief Finishes the bit-angle modulated slot and restores the slot timing of the timer.
+     */
+    void endBAMSlot();
+
+    /**
+     * @brief Starts the LED stripe slot with bit-angle modulation in STRIPE_MODE_GRAY, otherwise with its frame.
+     */
+    void outputStripeSlot();
+
+    /**
+     * @brief Encodes the bit planes of the stripe intensities in STRIPE_MODE_GRAY into a frame that is not shown.
+     */
+    void encodeStripeLevels(Frame& encoded);
+
+    /**
+     * @brief Enables the Timer2 compare B interrupt that ends the on-time of a slot, if needed.
+     */
+    void updateTimerDimming();
+
+    /**
+     * @brief Turns off all displays and data lines.
+     */
+    void blankDisplays();
+
+    /**
+     * @brief Builds the port masks for the port-register output path from the pin maps.
+     * 
+     * @return bool true if all data and select pins could be mapped onto HTL_MAX_PORTS ports.
+     */
+    bool initPorts();
+
+    /**
+     * @brief Converts the voltage of the switch ladder into a switch state.
+     */
+    int switchState(int analogValue);
+
+    /**
+     * @brief Reads the latest sample of an input written by the ADC interrupt.
+     */
+    int latestSample(int input);
+
+#if HTL_POT_FILTER
+    /**
+     * @brief Passes a raw potentiometer sample through oversampling, median, average and hysteresis.
+     * 
+     * @return bool true if a new filtered value was stored in potFiltered.
+     */
+    bool filterPotSample(uint16_t raw);
+
+    /**
+     * @brief Clears the state of the potentiometer filter after its configuration changed.
+     */
+    void resetPotFilter();
+#endif
+
+    bool potFilterActive();
+
+#if HTL_SWITCH_EVENTS
+    /**
+     * @brief Debounces a sample of the switch ladder and queues the resulting events.
+     */
+    void debounceSwitches(int analogValue, unsigned long now);
+
+    /**
+     * @brief Adds an event to the switch event queue, counts it as lost if the queue is full.
+     */
+    void pushSwitchEvent(uint8_t type, uint8_t switches);
+#endif
+
+    /**
+     * @brief Disconnects the RGB pins from the PWM timers after setRGB().
+     */
+    void releasePWM();
+
+#if HTL_FAST_IO
+    /**
+     * @brief Converts data lines into the active low port values of the data pins.
+     * 
+     * @param mode The display the lines belong to (0 for HEX, 1 for LED stripe).
+     * @param lines The data lines to switch on.
+     * @param data Receives one value per port, masked with dataMask.
+     */
+    void linesToPorts(int mode, uint16_t lines, uint8_t data[]);
+
+    /**
+     * @brief Stores precomputed port values and selects the given display.
+     */
+    void writePorts(int mode, const uint8_t data[]);
+#endif
+
+    void pinWrite(uint8_t pin, uint8_t level);
+    void pinOutput(uint8_t pin);
+
+    // Shared by all instances, only the cold setup and per-pin paths index them at run time
+    static constexpr uint8_t pinMapping[10] = {0, 1, 2, 3, 4, 5, 6, 8, 7, 9}; // abcdefgNhi
+    static constexpr uint8_t pinMappingStripe[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    static constexpr uint8_t selectPins[3] = {10, 11, 12}; // HEX-Panel, LED-Stripe, RGB-LED
+
+    // Note that switch 1 is S2 and switch 2 is S3
+    int switch1Threshold = 700;
+    int switchNoneThreshold = 900;
+    int switch12Threshold = 500;
+
+    unsigned long lastMultiplexTime = 0;
+    volatile bool timerMultiplex = false; // Slots are driven by the Timer2 interrupt
+    int currentMode = 0; // Start with HEX display
+    bool modesActive[3] = {false, false, false}; // Track active modes
+    int multiplexInterval = 1;
+
+    int HEX_mode = 0; // 0: display as HEX, 1: display as Decimal, 2: display as character, 3: display as String, 4/5: paged Decimal/HEX
+    int hexNumber = 0; // Variable to hold the current number for HEX display
+    int stripeMode = 0; //0: display as binary, 1: display as progress, 2: gray
+    int ledStripeValue = 0; // Variable for LED stripe
+#if HTL_GRAY_STRIPE
+    uint8_t stripeLevels[10] = {0}; // Intensities of STRIPE_MODE_GRAY
+#endif
+    char str[MAX_STRING_LENGTH + 1] = ""; // Characters of the string, for getString()
+    uint8_t strSegments[MAX_STRING_LENGTH] = {0}; // Segments of each character, encoded by setString()
+    uint8_t strLength = 0;
     int strDelay = 500;
     unsigned long lastStringUpdateTime = 0;
-    int strInx = 0;
+    uint8_t strInx = 0;
+#if HTL_PAGED_NUMBERS
+    uint16_t pagedMagnitude = 0; // Number of the paged modes without its sign, int16_t and uint16_t values
+    bool pagedNegative = false;
+    uint8_t pages[2][PAGED_MAX_PAGES] = {}; // Segments of each page, bit 7 lights the minus line
+    uint8_t pageCounts[2] = {0, 0};
+    volatile uint8_t pageBuffer = 0; // Page buffer being shown
+    volatile bool pagesPending = false; // The other buffer holds a new number for the next round
+    uint8_t pageInx = 0;
+#endif
     uint8_t red = 0, green = 0, blue = 0; // Variables for RGB LED
+
+    bool fastOutput = false; // Write frames to the port registers instead of digitalWrite()
+    bool pwmActive = false; // RGB pins are driven by the PWM timers
+    uint16_t ioWrites = 0; // Running count of pin/port writes
+    uint8_t lastFrameWrites = 0;
+
+    // Encoded content of all displays. The setters write the back frame, the
+    // refresh only shows the front frame and swaps the two when one is dirty.
+    struct Frame {
+        uint16_t lines[2]; // Data lines of the HEX display and LED stripe
+#if HTL_FAST_IO
+        uint8_t portData[2][HTL_MAX_PORTS]; // The same lines as port values
+#endif
+        uint8_t rgb[3];
+#if HTL_FAST_IO
+        uint8_t rgbPlanes[8][HTL_MAX_PORTS]; // Port values of every bit plane of the color
+#endif
+        bool stripeGray; // The LED stripe is shown with its bit planes
+#if HTL_GRAY_STRIPE
+        uint16_t stripePlanes[STRIPE_GRAY_BITS]; // Data lines of the upper bit planes of the stripe intensities
+#if HTL_FAST_IO
+        uint8_t stripePlanePorts[STRIPE_GRAY_BITS][HTL_MAX_PORTS]; // The same lines as port values
+#endif
+#endif
+    };
+    Frame frames[2] = {};
+    volatile uint8_t frontFrame = 0;
+    volatile uint8_t dirtyFrames = 0; // Bit per display changed since the last swap
+    uint8_t frameDepth = 0; // Nesting of beginFrame(), the setters stage their displays while it is open
+    volatile uint8_t stagedFrames = 0; // Bit per display to encode at commitFrame()
+    volatile bool frameHeld = false; // No swap until commitFrame() has encoded the staged displays
+    volatile bool rawFrameWaiting = false; // The frame of storeRawFrame() is not swapped to the front yet
+    volatile unsigned long rawFrameTime = 0; // millis() of the swap that showed it
+
+    int rgbMode = RGB_MODE_BAM;
+    volatile bool bamSlot = false; // A bit-angle modulated slot is in progress
+    uint8_t bamMode = MODE_RGB; // Display of the bit-angle modulated slot
+    uint8_t bamPhase = 0; // Steps of the bit-angle modulated slot shown so far
+    uint8_t rgbDither = 0; // Selects which of the low bit planes the last step shows
+#if HTL_GRAY_STRIPE
+    uint8_t stripeDither = 0; // The same for the gray LED stripe
+#endif
+    unsigned long bamPhaseStart = 0; // micros() at the start of the current step
+    unsigned int bamPhaseLength = 0; // Length of the current step in microseconds
+    uint8_t timerSlotCS = 0, timerSlotTop = 0; // Timer2 clock select and top for a slot
+    uint8_t timerBAMCS = 0; // Timer2 clock select during a bit-angle modulated slot
+
+    uint8_t modeWeights[3] = {1, 1, 1}; // Consecutive slots of each mode
+    uint8_t slotsLeft = 0; // Slots the current mode keeps before the next mode follows
+    uint8_t brightness = 255;
+    bool gammaCorrection = false;
+    uint8_t whiteBalance[3] = {255, 255, 255};
+    unsigned long slotStartMicros = 0; // micros() at the start of the polled slot, used for dimming and the task budget
+    bool slotDimmed = false;
+
+    volatile bool adcSampler = false; // readPot() and readSwitchState() use the ADC interrupt samples
+    volatile uint8_t adcInput = ANALOG_POT; // Input of the running conversion
+    volatile uint16_t adcValues[2] = {0, 0};
+    volatile unsigned long sampleTimes[2] = {0, 0}; // micros() of the latest sample
+    uint16_t sampleCounts[2] = {0, 0}; // Samples in the current rate window
+    unsigned long rateWindowStart[2] = {0, 0};
+    volatile unsigned long rateWindowMicros[2] = {0, 0}; // Length of the last complete rate window
+
+#if HTL_SWITCH_EVENTS
+    // Debouncing runs in the ADC interrupt, which is the only writer of eventHead
+    uint8_t switchCandidate = 0; // Switch bits of the latest samples
+    unsigned long candidateSince = 0; // micros() since the candidate is unchanged
+    volatile uint8_t switchStable = 0; // Debounced switch bits
+    unsigned long stableSince = 0;
+    bool longPressSent = false;
+    SwitchEvent switchEvents[SWITCH_EVENT_QUEUE];
+    volatile uint8_t eventHead = 0; // Next free entry, written by the interrupt
+    volatile uint8_t eventTail = 0; // Oldest entry, written by getSwitchEvent()
+    volatile unsigned int lostSwitchEvents = 0;
+#endif
+
+#if HTL_POT_FILTER
+    // Potentiometer filter, fed by readPot() or the ADC interrupt
+    uint8_t potOversampling = 0;
+    uint8_t potMedian = 1;
+    uint8_t potSmoothing = 0;
+    uint8_t potHysteresis = 0;
+    uint16_t potSum = 0; // Sum of the oversampled values
+    uint8_t potSumCount = 0;
+    uint16_t potHistory[POT_MEDIAN_MAX]; // Latest values for the median
+    uint8_t potHistoryCount = 0;
+    uint8_t potHistoryIndex = 0;
+    long potAverage = 0; // Moving average with 4 fractional bits
+    volatile bool potPrimed = false; // potFiltered holds a value
+    volatile uint16_t potFiltered = 0;
+#endif
+
+#if HTL_ANIMATIONS
+    // Animation tracks in the order they were queued, the first track of a display is running
+    struct Animation {
+        uint8_t target; // MODE_STRIPE or MODE_RGB
+        uint8_t effect;
+        uint8_t repeat; // Periods left, 0 for forever
+        bool started;
+        uint32_t phase; // Position in the period, one period is 1 << 24
+        uint32_t phaseStep; // Phase per millisecond
+        unsigned int duration; // Length of one period in milliseconds
+        unsigned long lastTime; // millis() of the last update
+        uint8_t from[3]; // Color when a fade started
+        uint8_t color[3]; // Fade target or blink color
+        int value; // Blinking LEDs of the stripe
+    };
+    Animation animations[ANIMATION_TRACKS];
+    int stripeRestoreMode = -1; // Stripe mode before the stripe animations started, -1 while none runs
+    int stripeRestoreValue = 0;
+#endif
+    volatile uint8_t animationCount = 0;
+
+#if HTL_TASKS
+    // Tasks of addTask(), waiting in the timer wheel bucket of (due % TASK_WHEEL_SIZE) or ready to run
+    struct Task {
+        TaskCallback callback;
+        unsigned int period;
+        uint8_t repeat; // Runs left, 0 for forever
+        uint8_t state; // Free, waiting in the wheel, ready or running
+        uint8_t next; // Next task + 1 in the same bucket, 0 at the end
+        unsigned int longest; // Longest run in microseconds
+        unsigned long due; // millis() of the next run
+    };
+    Task tasks[MAX_TASKS] = {};
+    uint8_t wheel[TASK_WHEEL_SIZE] = {0}; // First task + 1 of each bucket, 0 if empty
+    unsigned long wheelTime = 0; // millis() up to which the buckets were checked
+    uint8_t readyTasks = 0; // Bit mask of the due tasks
+#endif
+    uint8_t taskCount = 0;
+
+#if HTL_FAST_IO
+    uint8_t portCount = 0;
+    HTL_PORT_T* outPorts[HTL_MAX_PORTS];
+    uint8_t dataMask[HTL_MAX_PORTS]; // Data lines on each port
+    uint8_t selectMask[HTL_MAX_PORTS]; // Select lines on each port
+    uint8_t selectPort[3]; // Port index of each select line
+    uint8_t selectBit[3]; // Bit mask of each select line
+    uint8_t hexLineBits[10]; // (port index << 3) | bit for every line of pinMapping
+    uint8_t stripeLineBits[10]; // (port index << 3) | bit for every line of pinMappingStripe
+#endif
+
+#if HTL_MULTIPLEX_STATS
+    MultiplexStats stats = {};
+    bool statsStarted = false; // statsLastSlot holds the start of a slot
+    unsigned long statsLastSlot = 0; // micros() at the start of the last slot
+    unsigned long statsAverage = 0; // avgInterval with 4 fractional bits
+    unsigned long statsWindowStart = 0; // micros() at the start of the slotsPerSecond window
+    unsigned int statsWindowSlots = 0;
+    unsigned long statsLastUpdate = 0; // micros() of the last updateMultiplex()
+    unsigned int timerSlotMicros = 0; // Slot period of beginTimerMultiplex()
+#endif
+
+    unsigned long sleepMicros = 0; // Time spent in idle() since sleepWindowStart
+    unsigned long sleepWindowStart = 0; // micros() at the last resetSleepStats()
+    unsigned long wakeups = 0;
+};
+
+/**
+ * @brief Default configuration of HTL_onboardT: all displays and features, like HTL_onboard.
+ * 
+ * An own configuration derives from it and hides the members that differ.
+ */
+struct HTL_onboardConfig {
+    static constexpr bool hex = true; // Multiplex the HEX display
+    static constexpr bool stripe = true; // Multiplex the LED stripe
+    static constexpr bool rgb = true; // Multiplex the RGB LED
+    static constexpr bool strings = true; // Scroll strings in HEX_MODE_STRING and page numbers in the paged modes
+    static constexpr bool animations = HTL_ANIMATIONS != 0; // Advance the animations of animateRGB() and animateStripe()
+    static constexpr bool tasks = HTL_TASKS != 0; // Run the tasks of addTask()
+    static constexpr int hexMode = HEX_MODE_HEX; // Display mode of the HEX display after begin()
+    static constexpr int stripeMode = STRIPE_MODE_BIN; // Display mode of the LED stripe after begin()
+    static constexpr int multiplexInterval = 1; // Slot length in milliseconds
+};
+
+/**
+ * @brief HTL_onboard with the multiplexed displays and the refresh rate fixed at compile time.
+ * 
+ * updateMultiplex() only cycles through the displays enabled in Config. The branches of the other
+ * displays are constant, so the compiler removes them, and the Arduino builder (--gc-sections) does
+ * not link their encoders and output paths unless the sketch calls them itself. All other methods
+ * of HTL_onboard stay available; setModesMultiplex() and setMultiplexInterval() do not change the
+ * compiled slot sequence. Timer multiplexing uses multiplexTick() of HTL_onboard with the displays of Config.
+ * 
+ * @tparam Config The configuration, HTL_onboardConfig or a struct derived from it.
+ */
+template <class Config = HTL_onboardConfig>
+class HTL_onboardT : public HTL_onboard {
+    static_assert(Config::hex || Config::stripe || Config::rgb, "HTL_onboardT needs at least one display");
+    static_assert(Config::multiplexInterval >= 0, "The multiplex interval must not be negative");
+    static_assert(HTL_ANIMATIONS || !Config::animations, "Animations need HTL_ANIMATIONS");
+    static_assert(HTL_TASKS || !Config::tasks, "Tasks need HTL_TASKS");
+    static_assert(HTL_PAGED_NUMBERS || Config::hexMode < HEX_MODE_PAGED_DEC, "The paged HEX modes need HTL_PAGED_NUMBERS");
+    static_assert(HTL_GRAY_STRIPE || Config::stripeMode != STRIPE_MODE_GRAY, "STRIPE_MODE_GRAY needs HTL_GRAY_STRIPE");
+
+public:
+    /**
+     * @brief Initializes the pins and encodes the displays enabled in Config.
+     */
+    void begin() {
+        beginPins();
+        loadSwitchCalibration();
+
+        modesActive[MODE_HEX] = Config::hex;
+        modesActive[MODE_STRIPE] = Config::stripe;
+        modesActive[MODE_RGB] = Config::rgb;
+        multiplexInterval = Config::multiplexInterval;
+        HEX_mode = Config::hexMode;
+        stripeMode = Config::stripeMode;
+
+        if (Config::hex && Config::hexMode >= HEX_MODE_PAGED_DEC) {
+            showPagedNumber(true);
+        } else if (Config::hex) {
+            storeHexFrame();
+        }
+        if (Config::stripe) {
+            storeStripeFrame();
+        }
+        if (Config::rgb) {
+            storeRGBFrame();
+        }
+        swapFrames(); // Shown from the first slot on, also if it falls into a batch
+    }
+
+    /**
+     * @brief Shows the next display once the interval of Config is over, see HTL_onboard::updateMultiplex().
+     */
+    void updateMultiplex() {
+#if HTL_MULTIPLEX_STATS
+        recordLoopGap();
+#endif
+        pollMultiplex();
+        if (Config::tasks && taskCount) {
+            updateTasks();
+        }
+    }
+
+private:
+    static constexpr bool enabled(int mode) {
+        return (mode == MODE_HEX) ? Config::hex : ((mode == MODE_STRIPE) ? Config::stripe : Config::rgb);
+    }
+
+    // pollMultiplex() of HTL_onboard with the displays and interval of Config
+    void pollMultiplex() {
+        if (timerMultiplex) {
+            return; // Slots are driven by the timer interrupt
+        }
+
+        if ((Config::rgb || Config::stripe) && bamSlot) {
+            if (micros() - bamPhaseStart >= bamPhaseLength) {
+                lastMultiplexTime = millis();
+                if (bamPhase < RGB_BAM_STEPS) {
+                    outputBAMStep();
+                    return;
+                }
+                endBAMSlot();
+                slot();
+            }
+            return;
+        }
+
+        unsigned long currentTime = millis();
+
+        if (currentTime - lastMultiplexTime >= (unsigned long)Config::multiplexInterval) {
+            lastMultiplexTime = currentTime;
+
+            slot();
+
+            if (Config::rgb && currentMode == MODE_RGB && rgbMode == RGB_MODE_PWM) {
+                delay(RGB_DELAY);
+            }
+        } else if (brightness < 255 && !slotDimmed) {
+            // Turn the display off once its share of the interval is over
+            unsigned long onTime = ((unsigned long)Config::multiplexInterval * 1000UL * brightness) / 255;
+            if (micros() - slotStartMicros >= onTime) {
+                multiplexBlank();
+                slotDimmed = true;
+            }
+        }
+    }
+
+    // The slot of multiplexTick() with the display dispatch resolved at compile time
+    void slot() {
+        int mode = currentMode;
+        if (slotsLeft > 0 && enabled(mode)) {
+            slotsLeft--;
+        } else {
+            do {
+                mode = (mode == 2) ? 0 : mode + 1;
+            } while (!enabled(mode));
+            slotsLeft = modeWeights[mode] - 1;
+        }
+
+        uint16_t slotStartWrites = ioWrites;
+
+        if (Config::animations && animationCount) {
+            updateAnimations();
+        }
+        if (Config::hex && Config::strings && mode == MODE_HEX) {
+            advanceString();
+        }
+
+        startSlot();
+        if (Config::rgb && mode == MODE_RGB) {
+            outputRGBSlot();
+        } else if (Config::stripe && mode == MODE_STRIPE) {
+            outputStripeSlot();
+        } else {
+            outputLinesFrame(mode);
+        }
+        finishSlot(mode, slotStartWrites);
+    }
+};
+
+/**
+ * @brief Remote control of an HTL_onboard over a framed binary serial protocol.
+ * 
+ * A frame is PROTOCOL_SOF, the payload length (1 to PROTOCOL_MAX_PAYLOAD), the payload and the
+ * CRC-16/CCITT (polynomial 0x1021, start 0xFFFF, high byte first) of the length and payload bytes.
+ * The payload is a batch of commands (PROTOCOL_CMD_*), each an id byte followed by its arguments,
+ * 16 bit values low byte first. The commands of a frame are executed in order within one update(),
+ * so they show up together at the next multiplex slot with updateMultiplex().
+ * 
+ * Every frame with a valid checksum is answered with a frame of the same format whose payload is
+ * the status (PROTOCOL_OK or PROTOCOL_ERROR_*), the number of executed commands and, for each
+ * PROTOCOL_CMD_READ_INPUTS, the potentiometer value (2 bytes) and the switch state (1 byte).
+ * PROTOCOL_CMD_STREAM_STATS adds the streamed, dropped and late frames (2 bytes each).
+ * A frame with a bad checksum is answered with PROTOCOL_ERROR_CRC, so the sender can repeat it.
+ * 
+ * For the highest frame rate, a host can stream whole display frames instead of commands:
+ * PROTOCOL_STREAM_SOF, a sequence number, the HEX segments (abcdefg), the HEX flags (bit 0 minus
+ * sign, bit 1 tens digit), the 10 LED stripe bits (2 bytes), red, green, blue and the CRC-16 of
+ * the 8 bytes after PROTOCOL_STREAM_SOF. A streamed frame is not answered; it goes into the back
+ * frame with HTL_onboard::storeRawFrame() and is shown from the next multiplex slot on. Frames
+ * missing from the sequence or replaced before they were shown count as dropped, frames shown
+ * more than PROTOCOL_STREAM_LATE_MS after they arrived as late.
+ * 
+ * The bytes are received by the interrupt driven buffer of the stream (64 bytes with
+ * HardwareSerial), update() only parses what has arrived and never waits. On the HTL Uno,
+ * Serial uses D0 and D1, so the display lines on these pins stay dark while it is active.
+ */
+class HTL_onboardProtocol {
+public:
+    /**
+     * @brief Creates a protocol handler that controls onboard through stream.
+     * 
+     * @param onboard The displays and inputs to control.
+     * @param stream The serial port, e.g. Serial after Serial.begin().
+     */
+    HTL_onboardProtocol(HTL_onboard& onboard, Stream& stream);
+
+    /**
+     * @brief Parses the received bytes and executes at most one complete frame. Call it from loop().
+     * 
+     * @return true if a frame was executed.
+     */
+    bool update();
+
+    /**
+     * @brief Returns the number of executed command frames.
+     */
+    unsigned int getFrameCount();
+
+    /**
+     * @brief Returns the number of dropped frames (bad length, checksum or timeout).
+     */
+    unsigned int getErrorCount();
+
+    /**
+     * @brief Returns the number of streamed display frames stored in the back frame.
+     */
+    unsigned int getStreamedFrames();
+
+    /**
+     * @brief Returns the number of streamed display frames that were lost or replaced before they were shown.
+     */
+    unsigned int getDroppedFrames();
+
+    /**
+     * @brief Returns the number of streamed display frames shown later than PROTOCOL_STREAM_LATE_MS.
+     */
+    unsigned int getLateFrames();
+
+private:
+    void execute();
+    void storeStream();
+    void checkStream();
+    void sendFrame(const uint8_t* data, uint8_t size);
+    static uint16_t crc16(uint16_t crc, uint8_t data);
+
+    HTL_onboard& onboard;
+    Stream& stream;
+
+    uint8_t state;
+    uint8_t length;
+    uint8_t index;
+    uint16_t crc;
+    uint16_t frameCrc;
+    unsigned long lastByteTime;
+    uint8_t payload[PROTOCOL_MAX_PAYLOAD];
+
+    unsigned int frames;
+    unsigned int errors;
+
+    bool streaming; // The frame being received is a streamed display frame
+    bool streamStarted; // A streamed frame was received, streamSequence is valid
+    bool streamPending; // The last streamed frame is not shown yet, or its delay is not counted yet
+    uint8_t streamSequence; // Sequence number of the last streamed frame
+    unsigned long streamTime; // millis() when the last streamed frame arrived
+    unsigned int streamedFrames;
+    unsigned int droppedFrames;
+    unsigned int lateFrames;
 };
 
 #endif
\ No newline at end of file
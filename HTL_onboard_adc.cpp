@@ -0,0 +1,73 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Interrupt driven sampling of the potentiometer and the switches. This file only gets
+// linked if the sketch calls beginAnalogSampler(), so analogRead() keeps working for all
+// other sketches.
+
+#include "HTL_onboard.h"
+
+static HTL_onboard* samplerInstance = NULL;
+
+ISR(ADC_vect) {
+    if (samplerInstance) {
+        samplerInstance->samplerTick();
+    }
+}
+
+void HTL_onboard::beginAnalogSampler() {
+    if (adcSampler) {
+        return;
+    }
+
+    // Start with valid values, the first background conversions take about 200 microseconds
+    adcValues[ANALOG_POT] = analogRead(A0);
+    adcValues[ANALOG_SWITCHES] = analogRead(A1);
+
+    uint8_t oldSREG = SREG;
+    cli();
+    unsigned long now = micros();
+    for (uint8_t i = 0; i < 2; i++) {
+        sampleTimes[i] = now;
+        sampleCounts[i] = 0;
+        rateWindowStart[i] = now;
+        rateWindowMicros[i] = 0;
+    }
+    samplerInstance = this;
+    adcSampler = true;
+    adcInput = ANALOG_POT;
+
+    // AVcc reference, A0 first, ADC clock 16 MHz / 128 = 125 kHz like analogRead()
+    ADMUX = (1 << REFS0);
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADIF) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    SREG = oldSREG;
+}
+
+void HTL_onboard::endAnalogSampler() {
+    uint8_t oldSREG = SREG;
+    cli();
+    ADCSRA &= ~(1 << ADIE);
+    adcSampler = false;
+    samplerInstance = NULL;
+    SREG = oldSREG;
+
+    // Let the running conversion finish, so the next analogRead() gets its own channel
+    while (ADCSRA & (1 << ADSC)) {
+    }
+    ADCSRA |= (1 << ADIF);
+}
@@ -0,0 +1,111 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Switch threshold calibration, stored in EEPROM and loaded by begin().
+
+#include "HTL_onboard.h"
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#define CALIBRATION_MAGIC 0x48 // 'H'
+
+// Default thresholds, restored by clearSwitchCalibration()
+#define DEFAULT_SWITCH_1_THRESHOLD 700
+#define DEFAULT_SWITCH_NONE_THRESHOLD 900
+#define DEFAULT_SWITCH_12_THRESHOLD 500
+
+// Layout in EEPROM, the checksum covers the bytes before it
+struct SwitchCalibration {
+    uint8_t magic;
+    uint8_t version;
+    uint16_t switch1Threshold;
+    uint16_t switchNoneThreshold;
+    uint16_t switch12Threshold;
+    uint16_t crc;
+};
+
+static uint16_t calibrationCrc(const SwitchCalibration& calibration) {
+    const uint8_t* data = (const uint8_t*)&calibration;
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < offsetof(SwitchCalibration, crc); i++) {
+        crc = _crc_xmodem_update(crc, data[i]);
+    }
+    return crc;
+}
+
+int HTL_onboard::sampleSwitchLevel() {
+    int low = 1023;
+    int high = 0;
+    long sum = 0;
+    for (uint8_t i = 0; i < SWITCH_CALIBRATION_SAMPLES; i++) {
+        if (i > 0) {
+            delay(1);
+        }
+        int value = adcSampler ? latestSample(ANALOG_SWITCHES) : analogRead(A1);
+        low = min(low, value);
+        high = max(high, value);
+        sum += value;
+    }
+    if (high - low > SWITCH_CALIBRATION_SPREAD) {
+        return -1; // A switch moved or bounced
+    }
+    return (int)((sum + SWITCH_CALIBRATION_SAMPLES / 2) / SWITCH_CALIBRATION_SAMPLES);
+}
+
+bool HTL_onboard::calibrateSwitches(const int levels[4]) {
+    // Ladder order: S3 lowest, then both, S2 and none
+    const int ordered[4] = {levels[3], levels[1], levels[2], levels[0]};
+    for (uint8_t i = 0; i < 4; i++) {
+        if (ordered[i] < 0 || ordered[i] > 1023 || (i > 0 && ordered[i] - ordered[i - 1] < SWITCH_CALIBRATION_GAP)) {
+            return false;
+        }
+    }
+
+    SwitchCalibration calibration;
+    calibration.magic = CALIBRATION_MAGIC;
+    calibration.version = SWITCH_CALIBRATION_VERSION;
+    calibration.switch12Threshold = (ordered[0] + ordered[1]) / 2;
+    calibration.switch1Threshold = (ordered[1] + ordered[2]) / 2;
+    calibration.switchNoneThreshold = (ordered[2] + ordered[3]) / 2;
+    calibration.crc = calibrationCrc(calibration);
+
+    // Only changed bytes are written, a repeated calibration does not wear the EEPROM
+    eeprom_update_block(&calibration, (void*)SWITCH_CALIBRATION_ADDRESS, sizeof(calibration));
+    cfgSwitches(calibration.switch1Threshold, calibration.switchNoneThreshold, calibration.switch12Threshold);
+    return true;
+}
+
+bool HTL_onboard::loadSwitchCalibration() {
+    // An erased or foreign EEPROM is rejected after one byte, so begin() stays fast
+    if (eeprom_read_byte((const uint8_t*)SWITCH_CALIBRATION_ADDRESS) != CALIBRATION_MAGIC) {
+        return false;
+    }
+
+    SwitchCalibration calibration;
+    eeprom_read_block(&calibration, (const void*)SWITCH_CALIBRATION_ADDRESS, sizeof(calibration));
+    if (calibration.version != SWITCH_CALIBRATION_VERSION || calibration.crc != calibrationCrc(calibration)) {
+        return false;
+    }
+    cfgSwitches(calibration.switch1Threshold, calibration.switchNoneThreshold, calibration.switch12Threshold);
+    return true;
+}
+
+void HTL_onboard::clearSwitchCalibration() {
+    eeprom_update_byte((uint8_t*)SWITCH_CALIBRATION_ADDRESS, 0xFF);
+    cfgSwitches(DEFAULT_SWITCH_1_THRESHOLD, DEFAULT_SWITCH_NONE_THRESHOLD, DEFAULT_SWITCH_12_THRESHOLD);
+}
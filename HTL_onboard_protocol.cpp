@@ -0,0 +1,296 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Binary serial protocol for remote control of the displays and streaming of display
+// frames. This file only gets linked if the sketch creates an HTL_onboardProtocol.
+
+#include "HTL_onboard.h"
+
+#define PARSE_SOF 0
+#define PARSE_LENGTH 1
+#define PARSE_PAYLOAD 2
+#define PARSE_CRC_HIGH 3
+#define PARSE_CRC_LOW 4
+
+// Argument bytes of each command, PROTOCOL_CMD_STRING adds its characters
+static const uint8_t commandSizes[] PROGMEM = {
+    0, 2, 1, 1, 2, 3, 1, 2, 1, 1, 0, 0
+};
+
+HTL_onboardProtocol::HTL_onboardProtocol(HTL_onboard& onboard, Stream& stream)
+    : onboard(onboard), stream(stream), state(PARSE_SOF), length(0), index(0), crc(0), frameCrc(0),
+      lastByteTime(0), frames(0), errors(0), streaming(false), streamStarted(false), streamPending(false),
+      streamSequence(0), streamTime(0), streamedFrames(0), droppedFrames(0), lateFrames(0) {
+}
+
+bool HTL_onboardProtocol::update() {
+    unsigned long currentTime = millis();
+
+    // Drop a frame whose remaining bytes were lost, so it does not swallow the next one. Bytes
+    // already waiting in the receive buffer arrived in time, even after a long loop() pass.
+    if (state != PARSE_SOF && stream.available() == 0 && currentTime - lastByteTime >= PROTOCOL_TIMEOUT_MS) {
+        state = PARSE_SOF;
+        errors++;
+    }
+
+    checkStream();
+
+    // At most one frame per call, so a busy line cannot hold up the multiplexing
+    for (int budget = PROTOCOL_MAX_PAYLOAD + 5; budget > 0 && stream.available() > 0; budget--) {
+        uint8_t c = (uint8_t)stream.read();
+        lastByteTime = currentTime;
+
+        switch (state) {
+        case PARSE_SOF:
+            if (c == PROTOCOL_SOF) {
+                streaming = false;
+                state = PARSE_LENGTH;
+            } else if (c == PROTOCOL_STREAM_SOF) {
+                // Fixed size, the checksum covers the payload only
+                streaming = true;
+                length = PROTOCOL_STREAM_SIZE;
+                index = 0;
+                crc = 0xFFFF;
+                state = PARSE_PAYLOAD;
+            }
+            break;
+        case PARSE_LENGTH:
+            if (c == 0 || c > PROTOCOL_MAX_PAYLOAD) {
+                state = PARSE_SOF;
+                errors++;
+            } else {
+                length = c;
+                index = 0;
+                crc = crc16(0xFFFF, c);
+                state = PARSE_PAYLOAD;
+            }
+            break;
+        case PARSE_PAYLOAD:
+            payload[index++] = c;
+            crc = crc16(crc, c);
+            if (index == length) {
+                state = PARSE_CRC_HIGH;
+            }
+            break;
+        case PARSE_CRC_HIGH:
+            frameCrc = (uint16_t)c << 8;
+            state = PARSE_CRC_LOW;
+            break;
+        case PARSE_CRC_LOW:
+            state = PARSE_SOF;
+            if ((frameCrc | c) == crc) {
+                if (streaming) {
+                    storeStream();
+                } else {
+                    execute();
+                    frames++;
+                }
+                return true;
+            } else if (streaming) {
+                errors++; // Counted as dropped by the gap in the sequence
+            } else {
+                const uint8_t nak[2] = {PROTOCOL_ERROR_CRC, 0};
+                sendFrame(nak, 2);
+                errors++;
+            }
+            break;
+        }
+    }
+    return false;
+}
+
+void HTL_onboardProtocol::execute() {
+    uint8_t reply[PROTOCOL_MAX_REPLY];
+    uint8_t replyLength = 2;
+    uint8_t status = PROTOCOL_OK;
+    uint8_t executed = 0;
+    uint8_t i = 0;
+
+    // The commands of one frame show up together, also with timer multiplexing
+    onboard.beginFrame();
+    while (i < length) {
+        uint8_t command = payload[i++];
+        if (command == 0 || command > PROTOCOL_CMD_STREAM_STATS) {
+            status = PROTOCOL_ERROR_COMMAND;
+            break;
+        }
+
+        int size = pgm_read_byte(&commandSizes[command]);
+        if (command == PROTOCOL_CMD_STRING && i < length) {
+            size += payload[i];
+        }
+        if (i + size > length) {
+            status = PROTOCOL_ERROR_LENGTH;
+            break;
+        }
+
+        const uint8_t* arg = &payload[i];
+        switch (command) {
+        case PROTOCOL_CMD_HEX_NUMBER:
+            onboard.setHexNumber((int16_t)(arg[0] | (arg[1] << 8)));
+            break;
+        case PROTOCOL_CMD_CHAR:
+            onboard.setChar((char)arg[0]);
+            break;
+        case PROTOCOL_CMD_STRING: {
+            char text[MAX_STRING_LENGTH + 1];
+            uint8_t n = min(arg[0], MAX_STRING_LENGTH);
+            memcpy(text, &arg[1], n);
+            text[n] = 0;
+            onboard.setString(text);
+            break;
+        }
+        case PROTOCOL_CMD_STRIPE:
+            onboard.setLedStripeValue((int16_t)(arg[0] | (arg[1] << 8)));
+            break;
+        case PROTOCOL_CMD_RGB:
+            onboard.setRGB_Multiplex(arg[0], arg[1], arg[2]);
+            break;
+        case PROTOCOL_CMD_MODES: {
+            int modes[3];
+            int count = 0;
+            for (int mode = 0; mode < 3; mode++) {
+                if (arg[0] & (1 << mode)) {
+                    modes[count++] = mode;
+                }
+            }
+            onboard.setModesMultiplex(modes, count);
+            break;
+        }
+        case PROTOCOL_CMD_INTERVAL:
+            onboard.setMultiplexInterval((int16_t)(arg[0] | (arg[1] << 8)));
+            break;
+        case PROTOCOL_CMD_HEX_MODE:
+            onboard.setHexMode(arg[0]);
+            break;
+        case PROTOCOL_CMD_STRIPE_MODE:
+            onboard.setStripeMode(arg[0]);
+            break;
+        case PROTOCOL_CMD_READ_INPUTS: {
+            if (replyLength + 3 > PROTOCOL_MAX_REPLY) {
+                status = PROTOCOL_ERROR_LENGTH;
+                break;
+            }
+            int pot = onboard.readPot();
+            reply[replyLength++] = lowByte(pot);
+            reply[replyLength++] = highByte(pot);
+            reply[replyLength++] = (uint8_t)onboard.readSwitchState();
+            break;
+        }
+        case PROTOCOL_CMD_STREAM_STATS: {
+            if (replyLength + 6 > PROTOCOL_MAX_REPLY) {
+                status = PROTOCOL_ERROR_LENGTH;
+                break;
+            }
+            const unsigned int stats[3] = {streamedFrames, droppedFrames, lateFrames};
+            for (uint8_t s = 0; s < 3; s++) {
+                reply[replyLength++] = lowByte(stats[s]);
+                reply[replyLength++] = highByte(stats[s]);
+            }
+            break;
+        }
+        }
+        if (status != PROTOCOL_OK) {
+            break;
+        }
+
+        i += size;
+        executed++;
+    }
+    onboard.commitFrame();
+
+    reply[0] = status;
+    reply[1] = executed;
+    sendFrame(reply, replyLength);
+}
+
+void HTL_onboardProtocol::storeStream() {
+    // Frames missing from the sequence were lost on the line or had a bad checksum
+    uint8_t sequence = payload[0];
+    if (streamStarted && millis() - streamTime < PROTOCOL_STREAM_RESTART_MS) {
+        droppedFrames += (uint8_t)(sequence - streamSequence - 1);
+    }
+    streamStarted = true;
+    streamSequence = sequence;
+
+    // The previous frame is counted as late before its swap time is replaced
+    checkStream();
+
+    uint16_t stripe = payload[3] | (payload[4] << 8);
+    if (onboard.storeRawFrame(payload[1], payload[2] & 0x01, payload[2] & 0x02, stripe, payload[5], payload[6], payload[7]) && streamPending) {
+        droppedFrames++; // Replaced before the multiplexer showed it
+    }
+    streamPending = true;
+    streamTime = millis();
+    streamedFrames++;
+}
+
+void HTL_onboardProtocol::checkStream() {
+    // Only the swap that showed the streamed frame counts, not other changes of the displays
+    unsigned long shownTime;
+    if (streamPending && !onboard.rawFramePending(shownTime)) {
+        streamPending = false;
+        if (shownTime - streamTime > PROTOCOL_STREAM_LATE_MS) {
+            lateFrames++;
+        }
+    }
+}
+
+void HTL_onboardProtocol::sendFrame(const uint8_t* data, uint8_t size) {
+    // One write, so the frame goes into the transmit buffer in one piece
+    uint8_t frame[PROTOCOL_MAX_REPLY + 4];
+    uint16_t checksum = crc16(0xFFFF, size);
+
+    frame[0] = PROTOCOL_SOF;
+    frame[1] = size;
+    for (uint8_t i = 0; i < size; i++) {
+        frame[2 + i] = data[i];
+        checksum = crc16(checksum, data[i]);
+    }
+    frame[2 + size] = highByte(checksum);
+    frame[3 + size] = lowByte(checksum);
+    stream.write(frame, size + 4);
+}
+
+uint16_t HTL_onboardProtocol::crc16(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+unsigned int HTL_onboardProtocol::getFrameCount() {
+    return frames;
+}
+
+unsigned int HTL_onboardProtocol::getErrorCount() {
+    return errors;
+}
+
+unsigned int HTL_onboardProtocol::getStreamedFrames() {
+    return streamedFrames;
+}
+
+unsigned int HTL_onboardProtocol::getDroppedFrames() {
+    return droppedFrames;
+}
+
+unsigned int HTL_onboardProtocol::getLateFrames() {
+    return lateFrames;
+}
@@ -0,0 +1,61 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Idle sleep between the multiplex slots. This file only gets linked if the sketch calls idle().
+
+#include "HTL_onboard.h"
+#include <avr/sleep.h>
+
+void HTL_onboard::idle() {
+    // Polled steps shorter than the millis() tick would be delayed until it
+    if (!timerMultiplex && (bamSlot || (brightness < 255 && !slotDimmed))) {
+        return;
+    }
+
+    unsigned long start = micros();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    sleep_enable();
+    sei(); // The instruction after sei() still runs first, so no wake-up is lost before sleep_cpu()
+    sleep_cpu();
+    sleep_disable();
+    sleepMicros += micros() - start;
+    wakeups++;
+}
+
+uint8_t HTL_onboard::getSleepPercent() {
+    unsigned long elapsed = micros() - sleepWindowStart;
+    if (elapsed < 100) {
+        return 0;
+    }
+    return (uint8_t)min(sleepMicros / (elapsed / 100), 100UL);
+}
+
+unsigned long HTL_onboard::getSleepTime() {
+    return sleepMicros;
+}
+
+unsigned long HTL_onboard::getWakeups() {
+    return wakeups;
+}
+
+void HTL_onboard::resetSleepStats() {
+    sleepMicros = 0;
+    wakeups = 0;
+    sleepWindowStart = micros();
+}
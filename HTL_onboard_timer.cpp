@@ -0,0 +1,95 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+// Timer2 driven multiplexing. This file only gets linked if the sketch calls
+// beginTimerMultiplex(), so tone() keeps working for all other sketches.
+
+#include "HTL_onboard.h"
+
+static HTL_onboard* timerInstance = NULL;
+
+ISR(TIMER2_COMPA_vect) {
+    if (timerInstance) {
+        timerInstance->multiplexTick();
+    }
+}
+
+ISR(TIMER2_COMPB_vect) {
+    if (timerInstance) {
+        timerInstance->multiplexBlank();
+    }
+}
+
+void HTL_onboard::beginTimerMultiplex(unsigned int slotRate) {
+    // Timer2 prescalers and their clock select bits
+    const uint16_t prescalers[7] = {1, 8, 32, 64, 128, 256, 1024};
+
+    slotRate = constrain(slotRate, 62, 20000);
+
+    // Use the smallest prescaler that fits the period into the 8 bit counter
+    uint8_t cs = 7;
+    uint32_t top = 255;
+    for (uint8_t i = 0; i < 7; i++) {
+        uint32_t ticks = F_CPU / ((uint32_t)prescalers[i] * slotRate);
+        if (ticks <= 256) {
+            cs = i + 1;
+            top = ticks - 1;
+            break;
+        }
+    }
+
+    // Bit-angle modulated slots count 256 ticks of at least 2 microseconds
+    timerSlotCS = cs;
+    timerSlotTop = (uint8_t)top;
+    timerBAMCS = max(cs, 3);
+#if HTL_MULTIPLEX_STATS
+    timerSlotMicros = (top + 1) * prescalers[cs - 1] / (F_CPU / 1000000UL);
+#endif
+
+    uint8_t oldSREG = SREG;
+    cli();
+    timerInstance = this;
+    timerMultiplex = true;
+    bamSlot = false;
+    TCCR2A = (1 << WGM21); // CTC mode, OC2A/OC2B disconnected
+    TCCR2B = cs;
+    OCR2A = (uint8_t)top;
+    TCNT2 = 0;
+    TIFR2 = (1 << OCF2A);
+    TIMSK2 |= (1 << OCIE2A);
+    updateTimerDimming();
+    SREG = oldSREG;
+}
+
+void HTL_onboard::endTimerMultiplex() {
+    uint8_t oldSREG = SREG;
+    cli();
+    TIMSK2 &= ~((1 << OCIE2A) | (1 << OCIE2B));
+    // Back to the setup of the Arduino core, phase correct PWM with prescaler 64, so analogWrite()
+    // and tone() work again on pins 3 and 11
+    TCCR2A = (1 << WGM20);
+    TCCR2B = (1 << CS22);
+    timerMultiplex = false;
+    timerInstance = NULL;
+    bamSlot = false;
+    SREG = oldSREG;
+
+    // The display of the last slot would stay lit until the next updateMultiplex()
+    blankDisplays();
+}
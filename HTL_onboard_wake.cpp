@@ -0,0 +1,48 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Pin change wake-up for idle(). This file only gets linked if the sketch calls setWakePin(),
+// so the pin change interrupts stay free for other libraries in all other sketches.
+
+#include "HTL_onboard.h"
+
+// The interrupt only ends the sleep
+EMPTY_INTERRUPT(PCINT0_vect)
+EMPTY_INTERRUPT(PCINT1_vect)
+EMPTY_INTERRUPT(PCINT2_vect)
+
+void HTL_onboard::setWakePin(uint8_t pin, bool enabled) {
+    volatile uint8_t* mask = digitalPinToPCMSK(pin);
+    if (!mask) {
+        return;
+    }
+    uint8_t group = digitalPinToPCICRbit(pin);
+
+    uint8_t oldSREG = SREG;
+    cli();
+    if (enabled) {
+        *mask |= (1 << digitalPinToPCMSKbit(pin));
+        PCICR |= (1 << group);
+    } else {
+        *mask &= ~(1 << digitalPinToPCMSKbit(pin));
+        if (*mask == 0) {
+            PCICR &= ~(1 << group);
+        }
+    }
+    SREG = oldSREG;
+}
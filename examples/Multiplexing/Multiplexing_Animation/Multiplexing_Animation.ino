@@ -0,0 +1,38 @@
+// Set HTL_ANIMATIONS to 1 in HTL_onboard.h for the animations
+#include <HTL_onboard.h>
+
+#if !HTL_ANIMATIONS
+#error "Set HTL_ANIMATIONS to 1 in HTL_onboard.h"
+#endif
+
+HTL_onboard onboard;
+
+unsigned long lastHexUpdateTime = 0;
+int counter = 0;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+    onboard.setHexMode(HEX_MODE_DEC);
+
+    // The animations run in the multiplex slots, loop() never waits for them
+    onboard.animateStripe(ANIM_BOUNCE, 2000, 0, 0); // Bounce forever, 2 s per round trip
+
+    // Animations of the RGB LED run one after another
+    onboard.animateRGB(ANIM_FADE, 1000, 255, 0, 0); // Fade to red in 1 s
+    onboard.animateRGB(ANIM_BLINK, 500, 255, 0, 0, 3); // Blink red 3 times
+    onboard.animateRGB(ANIM_GRADIENT, 3000, 0, 0, 0, 0); // Then a color gradient forever
+}
+
+void loop() {
+    // The HEX display keeps counting while the LED stripe and the RGB LED are animated
+    unsigned long currentTime = millis();
+    if (currentTime - lastHexUpdateTime >= 1000) {
+        lastHexUpdateTime = currentTime;
+        counter = (counter + 1) % 20;
+        onboard.setHexNumber(counter);
+    }
+
+    onboard.updateMultiplex();
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+bool level = false;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+    onboard.setHexMode(HEX_MODE_DEC);
+    onboard.beginTimerMultiplex(1500);
+}
+
+void loop() {
+    level = !level;
+
+    // The timer interrupt refreshes the displays between any two setter calls. Inside
+    // beginFrame() and commitFrame() it keeps showing the last frame, and all changes
+    // appear together in the next slot. Without the batch, a slot could show the new
+    // stripe mode with the old value, which setStripeMode() cuts to the new range.
+    onboard.beginFrame();
+    if (level) {
+        onboard.setStripeMode(STRIPE_MODE_PROG);
+        onboard.setLedStripeValue(7);
+        onboard.setHexNumber(7);
+        onboard.setRGB_Multiplex(0, 255, 0);
+    } else {
+        onboard.setStripeMode(STRIPE_MODE_BIN);
+        onboard.setLedStripeValue(0x155);
+        onboard.setHexNumber(-5);
+        onboard.setRGB_Multiplex(255, 0, 0);
+    }
+    onboard.commitFrame();
+
+    delay(500);
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+// Measures the CPU cycles of the multiplex hot path on the board and prints them as CSV:
+//   name,output,calls,min_cycles,avg_cycles,max_cycles
+// Timer1 counts every CPU cycle while a call runs, so analogWrite() on pins 9 and 10 does not work
+// during the benchmark. Interrupts are off during a call, so only the call itself is counted.
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+const int CALLS = 64;
+uint16_t overhead = 0; // Cycles of starting and reading the counter
+
+uint16_t timeCall(void (*call)()) {
+    uint8_t oldSREG = SREG;
+    cli();
+    TCNT1 = 0;
+    call();
+    uint16_t cycles = TCNT1;
+    SREG = oldSREG;
+    return cycles - overhead;
+}
+
+void measure(const char* name, bool fast, void (*call)()) {
+    uint16_t minCycles = 0xFFFF;
+    uint16_t maxCycles = 0;
+    uint32_t totalCycles = 0;
+    for (int i = 0; i < CALLS; i++) {
+        delay(2); // Leave the multiplex interval and string delay behind
+        uint16_t cycles = timeCall(call);
+        totalCycles += cycles;
+        minCycles = min(minCycles, cycles);
+        maxCycles = max(maxCycles, cycles);
+    }
+
+    Serial.print(name);
+    Serial.print(fast ? F(",port,") : F(",pin,"));
+    Serial.print(CALLS);
+    Serial.print(',');
+    Serial.print(minCycles);
+    Serial.print(',');
+    Serial.print(totalCycles / CALLS);
+    Serial.print(',');
+    Serial.println(maxCycles);
+}
+
+// One slot of the display content, through multiplexTick() and updateMultiplex()
+void measureSlot(const char* name, bool fast, int mode, void (*content)()) {
+    const int modes[1] = {mode};
+    onboard.setModesMultiplex(modes, 1);
+    content();
+
+    char label[24];
+    snprintf(label, sizeof(label), "slot_%s", name);
+    measure(label, fast, []() { onboard.multiplexTick(); });
+    snprintf(label, sizeof(label), "update_%s", name);
+    measure(label, fast, []() { onboard.updateMultiplex(); });
+}
+
+void measureSuite(bool fast) {
+    onboard.setFastOutput(fast);
+
+    measureSlot("hex", fast, MODE_HEX, []() { onboard.setHexMode(HEX_MODE_HEX); onboard.setHexNumber(-0x1A); });
+    measureSlot("dec", fast, MODE_HEX, []() { onboard.setHexMode(HEX_MODE_DEC); onboard.setHexNumber(-17); });
+    measureSlot("char", fast, MODE_HEX, []() { onboard.setHexMode(HEX_MODE_CHAR); onboard.setChar('x'); });
+    measureSlot("string", fast, MODE_HEX, []() { onboard.setString("HTL Uno"); onboard.setHexMode(HEX_MODE_STRING); });
+    measureSlot("bin", fast, MODE_STRIPE, []() { onboard.setStripeMode(STRIPE_MODE_BIN); onboard.setLedStripeValue(0x2AA); });
+    measureSlot("prog", fast, MODE_STRIPE, []() { onboard.setStripeMode(STRIPE_MODE_PROG); onboard.setLedStripeValue(7); });
+#if HTL_GRAY_STRIPE
+    measureSlot("gray", fast, MODE_STRIPE, []() {
+        const uint8_t levels[10] = {255, 200, 160, 128, 96, 64, 32, 16, 8, 0};
+        onboard.setStripeMode(STRIPE_MODE_GRAY);
+        onboard.setStripeLevels(levels);
+    });
+#endif
+    measureSlot("rgb", fast, MODE_RGB, []() { onboard.setRGB_Multiplex(255, 128, 0); });
+
+    onboard.setStripeMode(STRIPE_MODE_BIN);
+    measure("writeChar", fast, []() { onboard.writeChar('x'); });
+    measure("writeHex", fast, []() { onboard.writeHex(0x1A); });
+    measure("writeBinary", fast, []() { onboard.writeBinary(0x2AA); });
+    measure("setMode", fast, []() { onboard.setMode(MODE_HEX, true); });
+    measure("readSwitchState", fast, []() { onboard.readSwitchState(); });
+    measure("readPot", fast, []() { onboard.readPot(); });
+
+    // The setters encode the back frame: glyphs, port values, color correction and bit planes
+    measure("setHexNumber", fast, []() { onboard.setHexNumber(-0x1A); });
+    measure("setLedStripeValue", fast, []() { onboard.setLedStripeValue(0x2AA); });
+    measure("setRGB_Multiplex", fast, []() { onboard.setRGB_Multiplex(255, 128, 0); });
+    onboard.setGammaCorrection(true);
+    measure("setRGB_Multiplex_gamma", fast, []() { onboard.setRGB_Multiplex(255, 128, 0); });
+    onboard.setGammaCorrection(false);
+    measure("storeRawFrame", fast, []() { onboard.storeRawFrame(0x7E, true, false, 0x155, 255, 128, 0); });
+}
+
+void setup() {
+    Serial.begin(115200);
+    onboard.begin();
+
+    // Timer1 in normal mode without prescaler counts CPU cycles
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);
+    overhead = 0;
+    overhead = timeCall([]() {});
+
+    Serial.println(F("name,output,calls,min_cycles,avg_cycles,max_cycles"));
+#if HTL_FAST_IO
+    measureSuite(true);
+#endif
+    measureSuite(false);
+
+    // Back to the setup of the Arduino core for analogWrite() on pins 9 and 10
+    TCCR1A = (1 << WGM10);
+    TCCR1B = (1 << CS11) | (1 << CS10);
+}
+
+void loop() {
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+// Set HTL_GRAY_STRIPE to 1 in HTL_onboard.h for STRIPE_MODE_GRAY
+#include <HTL_onboard.h>
+
+#if !HTL_GRAY_STRIPE
+#error "Set HTL_GRAY_STRIPE to 1 in HTL_onboard.h"
+#endif
+
+HTL_onboard onboard;
+
+int position = 0;
+int direction = 1;
+unsigned long lastStep = 0;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_STRIPE};
+    onboard.setModesMultiplex(activeModes, 1);
+    onboard.setStripeMode(STRIPE_MODE_GRAY);
+    onboard.setGammaCorrection(true); // Even steps of the fading tail
+}
+
+void loop() {
+    onboard.updateMultiplex();
+
+    if (millis() - lastStep >= 80) {
+        lastStep = millis();
+
+        // The running LED leaves a tail that halves its intensity with each LED
+        uint8_t levels[10];
+        for (int i = 0; i < 10; i++) {
+            levels[i] = onboard.getStripeLevel(i) / 2;
+        }
+        levels[position] = 255;
+        onboard.setStripeLevels(levels);
+
+        position += direction;
+        if (position == 0 || position == 9) {
+            direction = -direction;
+        }
+    }
+}
\ No newline at end of file
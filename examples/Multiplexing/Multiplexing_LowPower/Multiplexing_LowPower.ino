@@ -0,0 +1,34 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+int counter = 0;
+unsigned long lastCountTime = 0;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+    onboard.setHexMode(HEX_MODE_DEC);
+    onboard.setStripeMode(STRIPE_MODE_PROG);
+    onboard.setRGB_Multiplex(0, 64, 0);
+
+    // The Timer2 interrupt wakes the MCU for every slot
+    onboard.beginTimerMultiplex(1000);
+}
+
+void loop() {
+    unsigned long currentTime = millis();
+    if (currentTime - lastCountTime >= 1000) {
+        lastCountTime = currentTime;
+        onboard.setHexNumber(counter % 20); // HEX_MODE_DEC shows 0 to 19
+        counter++;
+
+        // The LED stripe shows the share of the last second spent asleep, one LED per 10%
+        onboard.setLedStripeValue(onboard.getSleepPercent() / 10);
+        onboard.resetSleepStats();
+    }
+
+    // Sleep until the next interrupt instead of spinning
+    onboard.idle();
+}
\ No newline at end of file
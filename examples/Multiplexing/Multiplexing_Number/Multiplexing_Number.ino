@@ -0,0 +1,31 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+int hexMode = HEX_MODE_PAGED_DEC;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE};
+    onboard.setModesMultiplex(activeModes, 2);
+    onboard.setStripeMode(STRIPE_MODE_PROG);
+    onboard.setHexMode(hexMode);
+    onboard.setStringDelay(400); // Each digit is shown for 0.4 seconds
+}
+
+void loop() {
+    // Hold S2 to show the number in hexadecimal, a new mode starts the number again
+    int mode = (onboard.readSwitchState() == 2) ? HEX_MODE_PAGED_HEX : HEX_MODE_PAGED_DEC;
+    if (mode != hexMode) {
+        hexMode = mode;
+        onboard.setHexMode(hexMode);
+    }
+
+    // The potentiometer as a signed 16-bit value from -32768 to 32704. A new number
+    // waits for the end of the current one, so the digits of two numbers never mix.
+    int pot = onboard.readPot();
+    onboard.setPagedNumber((long)pot * 64 - 32768);
+    onboard.setLedStripeValue(pot / 103);
+
+    onboard.updateMultiplex();
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+// Set HTL_MULTIPLEX_STATS to 1 in HTL_onboard.h to record the multiplex timing
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+unsigned long lastReportTime = 0;
+
+void setup() {
+    Serial.begin(115200);
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+    onboard.setHexNumber(0x1A);
+    onboard.setLedStripeValue(0x2AA);
+    onboard.setRGB_Multiplex(255, 128, 0);
+}
+
+void loop() {
+    // Other work of the sketch delays the next slot, the stats show how much
+    delayMicroseconds(random(0, 1500));
+
+    unsigned long currentTime = millis();
+    if (currentTime - lastReportTime >= 5000) {
+        lastReportTime = currentTime;
+        onboard.printMultiplexStats(Serial);
+        onboard.resetMultiplexStats();
+    }
+
+    onboard.updateMultiplex();
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+// Set HTL_TASKS to 1 in HTL_onboard.h for addTask()
+#include <HTL_onboard.h>
+
+#if !HTL_TASKS
+#error "Set HTL_TASKS to 1 in HTL_onboard.h"
+#endif
+
+HTL_onboard onboard;
+
+int counter = 0;
+int runningLED = 0;
+
+void count() {
+    onboard.setHexNumber(counter);
+    counter = (counter + 1) % 16;
+}
+
+void runLED() {
+    onboard.setLedStripeValue(1 << runningLED);
+    runningLED = (runningLED + 1) % 10;
+}
+
+void followPot() {
+    // Potentiometer 0 to 1023 as red to blue
+    int pot = onboard.readPot();
+    onboard.setRGB_Multiplex(255 - pot / 4, 0, pot / 4);
+}
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+
+    // Three timers without a millis() comparison in loop()
+    onboard.addTask(count, 500);
+    onboard.addTask(runLED, 100);
+    onboard.addTask(followPot, 50);
+}
+
+void loop() {
+    // Shows the next display and runs the due tasks in the time left before the next slot
+    onboard.updateMultiplex();
+}
\ No newline at end of file
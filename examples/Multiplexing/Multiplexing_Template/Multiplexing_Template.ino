@@ -0,0 +1,29 @@
+#include <HTL_onboard.h>
+
+// Only the HEX display and the LED stripe are multiplexed. The configuration is fixed at
+// compile time, so the code for the RGB LED, strings and animations is not linked into the sketch.
+struct PotConfig : HTL_onboardConfig {
+    static constexpr bool rgb = false;
+    static constexpr bool strings = false;
+    static constexpr bool animations = false;
+    static constexpr int hexMode = HEX_MODE_DEC;
+    static constexpr int stripeMode = STRIPE_MODE_PROG;
+    static constexpr int multiplexInterval = 2;
+};
+
+HTL_onboardT<PotConfig> onboard;
+
+void setup() {
+    // Initialize the pins and the displays of PotConfig
+    onboard.begin();
+}
+
+void loop() {
+    int potValue = onboard.readPot();
+
+    // Show the potentiometer as 0 to 10 on the HEX display and as a progress bar on the LED stripe
+    onboard.setHexNumber(potValue / 100);
+    onboard.setLedStripeValue(potValue / 93);
+
+    onboard.updateMultiplex();
+}
\ No newline at end of file
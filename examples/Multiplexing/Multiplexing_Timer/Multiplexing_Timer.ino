@@ -0,0 +1,29 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+int counter = 0;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+    onboard.setHexMode(HEX_MODE_DEC);
+    onboard.setRGB_Multiplex(0, 0, 255);
+
+    // Refresh the displays from the Timer2 interrupt with 1500 slots per second
+    onboard.beginTimerMultiplex(1500);
+}
+
+void loop() {
+    // loop() is free for slow application code, the displays keep refreshing in the background
+    onboard.setHexNumber(counter % 20);
+    onboard.setLedStripeValue(counter);
+
+    counter++;
+    if (counter > 1023) {
+        counter = 0;
+    }
+
+    delay(250);
+}
@@ -3,14 +3,6 @@
 // Create an instance of the HTL_onboard class
 HTL_onboard onboard;
 
-// Only update LED stripe every now and then, because the potentiometer tends to float.
-// Doing this will reduce flickering in the LSB
-
-// Variable to store the last time the LED stripe was updated
-unsigned long lastUpdateTime = 0;
-// Update interval for the LED stripe (in milliseconds)
-const unsigned long updateInterval = 100;
-
 void setup() {
     // Initialize the HTL_onboard library
     onboard.begin();
@@ -23,25 +15,20 @@ void setup() {
 
     // Set the multiplexing interval (in milliseconds)
     onboard.setMultiplexInterval(1); // Change interval as needed
+
+    // Sample the potentiometer and switches in the background, so reading them does not wait for the ADC
+    onboard.beginAnalogSampler();
+
+    // The potentiometer tends to float, filter it so the LSB of the LED stripe does not flicker
+    onboard.setPotOversampling(2); // Average 16 samples per value
+    onboard.setPotMedian(3); // Remove single spikes
+    onboard.setPotSmoothing(2); // Moving average
+    onboard.setPotHysteresis(1); // Ignore changes of one step, reach 0 and 1023 reliably
 }
 
 void loop() {
-    // Check if it's time to update the LED stripe
-    unsigned long currentTime = millis();
-    if (currentTime - lastUpdateTime >= updateInterval) {
-        // Read the value from the potentiometer
-        int potValue = onboard.readPot();
-        // If reading is close to maximum, display all leds on
-        if (potValue >= 1022) {
-          potValue = 1023;
-        }
-
-        // Display the potentiometer value in binary on the LED stripe
-        onboard.setLedStripeValue(potValue);
-
-        // Update the last update time
-        lastUpdateTime = currentTime;
-    }
+    // Display the filtered potentiometer value in binary on the LED stripe
+    onboard.setLedStripeValue(onboard.readPot());
 
     // Display the switch state on the HEX display
     onboard.setHexNumber(onboard.readSwitchState());
@@ -0,0 +1,27 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+unsigned long lastUpdateTime = 0;
+uint16_t hue = 0;
+
+void setup() {
+    onboard.begin();
+
+    // Equal steps of the color look like equal steps of brightness
+    onboard.setGammaCorrection(true);
+    // Green and blue LEDs are brighter than the red one, tune white to look neutral
+    onboard.setWhiteBalance(255, 200, 180);
+}
+
+void loop() {
+    // Sweep through all colors in about 3.6 seconds, without delay() and floating point math
+    unsigned long currentTime = millis();
+    if (currentTime - lastUpdateTime >= 10) {
+        lastUpdateTime = currentTime;
+        hue = (hue + 1) % 360;
+
+        // Full saturation and brightness, the potentiometer could be used for them as well
+        onboard.setHSV(hue, 255, 255);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+HTL_onboardProtocol protocol(onboard, Serial);
+
+void setup() {
+    Serial.begin(115200);
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 3);
+}
+
+void loop() {
+    // Executes the commands of a received frame, e.g. sent with extras/host/htl_remote.py:
+    //   htl_remote.py /dev/ttyACM0 -w 2 hex 42 rgb 0 0 255 stripe 0x3FF read
+    // or stores a streamed display frame:
+    //   htl_remote.py /dev/ttyACM0 -w 2 --stream 10 --rate 500
+    protocol.update();
+
+    onboard.updateMultiplex();
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+// Order in which the switch states are asked for, readSwitchState() numbering
+const int calibrationOrder[] = {0, 2, 3, 1}; // none, S2, S3, both
+
+int levels[4];
+int step = 4; // Next state of calibrationOrder to measure, 4 when not calibrating
+
+bool isNewLevel(int level) {
+    for (int i = 0; i < step; i++) {
+        if (abs(level - levels[calibrationOrder[i]]) < SWITCH_CALIBRATION_GAP) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void showStep() {
+    // Show the state to set: 0 none, 2 S2, 3 S3 and 1 both switches
+    onboard.setHexNumber(calibrationOrder[step]);
+    onboard.setRGB_Multiplex(0, 0, 255);
+}
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_RGB};
+    onboard.setModesMultiplex(activeModes, 2);
+    onboard.beginTimerMultiplex(1000);
+
+    // begin() already loaded a stored calibration, calibrate if there is none
+    // or if the potentiometer is turned fully left at reset
+    if (!onboard.loadSwitchCalibration() || onboard.readPot() < 10) {
+        step = 0;
+        showStep();
+    }
+}
+
+void loop() {
+    if (step == 4) {
+        onboard.setHexNumber(onboard.readSwitchState());
+        delay(50);
+        return;
+    }
+
+    // Wait until the switches are held still in a new position
+    int level = onboard.sampleSwitchLevel();
+    if (level < 0 || !isNewLevel(level)) {
+        return;
+    }
+    levels[calibrationOrder[step]] = level;
+    step++;
+
+    if (step < 4) {
+        // Let the switches settle before the next state
+        onboard.setRGB_Multiplex(255, 255, 255);
+        delay(500);
+        showStep();
+        return;
+    }
+
+    // Green if the levels were stored, red if they are too close or out of order
+    if (onboard.calibrateSwitches(levels)) {
+        onboard.setRGB_Multiplex(0, 255, 0);
+    } else {
+        onboard.setRGB_Multiplex(255, 0, 0);
+    }
+    delay(1000);
+    onboard.setRGB_Multiplex(0, 0, 0);
+}
\ No newline at end of file
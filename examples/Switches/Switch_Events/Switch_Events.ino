@@ -0,0 +1,33 @@
+#include <HTL_onboard.h>
+
+HTL_onboard onboard;
+
+int counter = 0;
+
+void setup() {
+    onboard.begin();
+    int activeModes[] = {MODE_HEX, MODE_STRIPE};
+    onboard.setModesMultiplex(activeModes, 2);
+    onboard.setHexMode(HEX_MODE_DEC);
+
+    // The switches are debounced in the background, loop() only handles the events
+    onboard.beginAnalogSampler();
+}
+
+void loop() {
+    SwitchEvent event;
+    while (onboard.getSwitchEvent(event)) {
+        if (event.type == SWITCH_EVENT_PRESS && event.switches == SWITCH_S2) {
+            counter++; // S2 counts up
+        } else if (event.type == SWITCH_EVENT_PRESS && event.switches == SWITCH_S3) {
+            counter--; // S3 counts down
+        } else if (event.type == SWITCH_EVENT_LONG_PRESS || event.type == SWITCH_EVENT_BOTH) {
+            counter = 0; // Holding a switch or pressing both resets the counter
+        }
+        counter = constrain(counter, -19, 19);
+    }
+
+    onboard.setHexNumber(counter);
+    onboard.setLedStripeValue(onboard.getSwitches());
+    onboard.updateMultiplex();
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Host replacement for the Arduino core. Models an ATmega328P based HTL Uno with a
+// virtual clock, virtual port registers and scripted analog inputs, see HTL_host.h.
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define ARDUINO 10819
+#define ARDUINO_AVR_UNO
+#define HTL_HOST 1
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LED_BUILTIN 13
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define NOT_A_PIN 0
+#define NOT_A_PORT 0
+#define PB 2
+#define PC 3
+#define PD 4
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define bit(b) (1UL << (b))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define lowByte(w) ((uint8_t) ((w) & 0xff))
+#define highByte(w) ((uint8_t) ((w) >> 8))
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+
+// Uno pin to port mapping: D0-D7 on PORTD, D8-D13 on PORTB, A0-A5 on PORTC
+#define digitalPinToPort(P) (((P) <= 7) ? PD : (((P) <= 13) ? PB : (((P) <= 19) ? PC : NOT_A_PIN)))
+#define digitalPinToBitMask(P) ((uint8_t)(1 << (((P) <= 7) ? (P) : (((P) <= 13) ? (P) - 8 : (P) - 14))))
+#define portOutputRegister(P) htl_host::portRegister(P)
+#define digitalPinToPCICR(P) (((P) <= 21) ? (&PCICR) : ((uint8_t*)0))
+#define digitalPinToPCICRbit(P) (((P) <= 7) ? 2 : (((P) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(P) (((P) <= 7) ? (&PCMSK2) : (((P) <= 13) ? (&PCMSK0) : (((P) <= 21) ? (&PCMSK1) : ((uint8_t*)0))))
+#define digitalPinToPCMSKbit(P) (((P) <= 7) ? (P) : (((P) <= 13) ? ((P) - 8) : ((P) - 14)))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+int analogRead(uint8_t pin);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class String {
+public:
+    String(const char* cstr = "") : s(cstr ? cstr : "") {}
+    String(const __FlashStringHelper* str) : s(reinterpret_cast<const char*>(str)) {}
+    String(char c) : s(1, c) {}
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+
+    unsigned int length() const { return (unsigned int)s.length(); }
+    const char* c_str() const { return s.c_str(); }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+    char operator[](unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    char& operator[](unsigned int index) { return s[index]; }
+
+    bool concat(const String& str) { s += str.s; return true; }
+    String& operator+=(const String& rhs) { s += rhs.s; return *this; }
+    String& operator+=(const char* rhs) { s += rhs; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    friend String operator+(const String& lhs, const String& rhs) { String r(lhs); r += rhs; return r; }
+
+    bool operator==(const String& rhs) const { return s == rhs.s; }
+    bool operator==(const char* rhs) const { return s == rhs; }
+    bool operator!=(const String& rhs) const { return s != rhs.s; }
+
+    void toUpperCase() { for (size_t i = 0; i < s.length(); i++) s[i] = (char)toupper(s[i]); }
+    void toLowerCase() { for (size_t i = 0; i < s.length(); i++) s[i] = (char)tolower(s[i]); }
+    long toInt() const { return atol(s.c_str()); }
+
+private:
+    std::string s;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+    size_t print(const __FlashStringHelper* str) { return write(reinterpret_cast<const char*>(str)); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud);
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#include "HTL_host.h"
+
+#endif
@@ -0,0 +1,940 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <vector>
+#include <utility>
+
+#include "Arduino.h"
+#include <avr/eeprom.h>
+
+HostPort PORTB(PB);
+HostPort PORTC(PC);
+HostPort PORTD(PD);
+uint8_t DDRB, DDRC, DDRD;
+uint8_t SREG = 0x80;
+uint8_t TCCR2A, TCCR2B, OCR2A, OCR2B, TCNT2, TIMSK2;
+HostFlags TIFR2;
+uint8_t TCCR1A, TCCR1B;
+HostTCNT1 TCNT1;
+uint8_t ADMUX;
+HostADCSRA ADCSRA;
+uint16_t ADC;
+uint8_t SMCR;
+uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2;
+
+// Interrupt handlers of the library, only present if linked in
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER2_COMPB_vect(void) __attribute__((weak));
+extern "C" void ADC_vect(void) __attribute__((weak));
+
+HardwareSerial Serial;
+
+namespace {
+    // HTL Uno wiring: data lines on D0-D9, active-low selects for HEX, stripe and RGB on D10-D12
+    const uint8_t SELECT_PINS[3] = {10, 11, 12};
+    const uint8_t RGB_PINS[3] = {5, 6, 9};
+    const char* const DISPLAY_NAMES[3] = {"HEX", "STRIPE", "RGB"};
+
+    // Patterns shorter than this are transients of a frame being written. Blanking
+    // with the select line still active is ignored unless it is held for a while.
+    const uint64_t SETTLE_CYCLES = 400;
+    const uint64_t SETTLE_BLANK_CYCLES = 8000;
+
+    struct Window {
+        bool selected;
+        uint32_t pattern; // Current data pattern, packed colour for the RGB LED
+        uint64_t patternSince;
+    };
+
+    uint64_t now = 0;
+    uint64_t lastObserve = 0;
+    htl_host::Stats counters;
+    htl_host::DisplayStats displays[3];
+    Window windows[3];
+    uint64_t rgbLevelCycles[3]; // Brightness of each color integrated over the cycles the RGB LED was selected
+    uint8_t pwm[20];
+    bool pwmOn[20];
+    std::vector<std::pair<unsigned long, int> > scripts[6];
+    int analogNow[6];
+    FILE* trace = NULL;
+    FILE* vcd = NULL;
+    uint64_t vcdTime = 0; // Time of the last time stamp in the waveform
+    char vcdLines[13]; // Recorded value of D0-D12: '0', '1', 'z' (input) or 'x' (PWM)
+    int vcdDuty[3]; // Recorded duty cycle of the RGB pins
+    uint8_t eeprom[E2END + 1];
+    bool eepromErased = false; // Filled with 0xFF on first use, like a new chip
+    uint32_t timer2Prescale = 0; // Cycles not yet counted by the prescaler
+    bool inInterrupt = false;
+    bool adcBusy = false;
+    uint8_t adcChannel = 0; // Channel latched at the start of the conversion
+    uint64_t adcDone = 0; // Cycle the running conversion finishes
+
+    // Serial receive buffer of the core, filled from the attached file descriptor
+    const int SERIAL_RX_BUFFER_SIZE = 64;
+    int serialFd = -1;
+    uint8_t serialRx[SERIAL_RX_BUFFER_SIZE];
+    int serialHead = 0;
+    int serialCount = 0;
+
+    void pollSerial() {
+        if (serialFd < 0 || serialCount == SERIAL_RX_BUFFER_SIZE) {
+            return;
+        }
+        uint8_t buf[SERIAL_RX_BUFFER_SIZE];
+        ssize_t n = ::read(serialFd, buf, SERIAL_RX_BUFFER_SIZE - serialCount);
+        for (ssize_t i = 0; i < n; i++) {
+            serialRx[(serialHead + serialCount++) % SERIAL_RX_BUFFER_SIZE] = buf[i];
+        }
+    }
+
+    const uint32_t COST_INTERRUPT = 24; // Vector jump, prologue and epilogue of an ISR
+    const uint64_t TIMER0_TICK_CYCLES = 64 * 256; // Timer0 overflow that counts millis(), always running
+    unsigned long vectorsRun = 0;
+
+    uint32_t timer2Divider() {
+        static const uint16_t dividers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+        return dividers[TCCR2B & 0x07];
+    }
+
+    uint32_t timer2Top() {
+        return (TCCR2A & (1 << WGM21)) ? OCR2A : 255;
+    }
+
+    // Timer ticks until the counter wraps and until it matches OCR2B before that (0 if it does not)
+    void timer2Distances(uint32_t& toWrap, uint32_t& toCompareB) {
+        uint32_t top = timer2Top();
+        bool belowTop = TCNT2 <= top;
+        toWrap = belowTop ? top - TCNT2 + 1 : 256 - TCNT2;
+        toCompareB = (OCR2B > TCNT2 && (OCR2B <= top || !belowTop)) ? OCR2B - TCNT2 : 0;
+    }
+
+    // Cycles until the next Timer2 event (wrap or compare B match), 0 if stopped
+    uint64_t timer2Remaining() {
+        uint32_t divider = timer2Divider();
+        if (!divider) {
+            return 0;
+        }
+        uint32_t toWrap, toCompareB;
+        timer2Distances(toWrap, toCompareB);
+        uint32_t ticks = (toCompareB && toCompareB < toWrap) ? toCompareB : toWrap;
+        return (uint64_t)ticks * divider - timer2Prescale;
+    }
+
+    void stepTimer2(uint64_t n) {
+        uint32_t divider = timer2Divider();
+        if (!divider) {
+            return;
+        }
+        uint64_t ticks = (timer2Prescale + n) / divider;
+        timer2Prescale = (uint32_t)((timer2Prescale + n) % divider);
+        while (ticks) {
+            uint32_t toWrap, toCompareB;
+            timer2Distances(toWrap, toCompareB);
+            bool belowTop = TCNT2 <= timer2Top();
+            if (toCompareB && toCompareB < toWrap) {
+                if (ticks < toCompareB) {
+                    TCNT2 = (uint8_t)(TCNT2 + ticks);
+                    break;
+                }
+                ticks -= toCompareB;
+                TCNT2 = OCR2B;
+                TIFR2.raise(1 << OCF2B);
+                continue;
+            }
+            if (ticks < toWrap) {
+                TCNT2 = (uint8_t)(TCNT2 + ticks);
+                break;
+            }
+            ticks -= toWrap;
+            TCNT2 = 0;
+            TIFR2.raise((belowTop && (TCCR2A & (1 << WGM21))) ? (1 << OCF2A) : (1 << TOV2));
+            if (OCR2B == 0) {
+                TIFR2.raise(1 << OCF2B);
+            }
+        }
+    }
+
+    // Runs an interrupt handler like the CPU: interrupts disabled during the handler
+    void runVector(void (*vector)(void)) {
+        inInterrupt = true;
+        vectorsRun++;
+        SREG &= ~0x80;
+        htl_host::advance(COST_INTERRUPT);
+        if (vector) {
+            vector();
+        }
+        SREG |= 0x80;
+        inInterrupt = false;
+    }
+
+    void dispatchInterrupts() {
+        if (inInterrupt || !(SREG & 0x80)) {
+            return;
+        }
+        // Pending vectors in the priority order of the ATmega328P, each clears its flag
+        for (;;) {
+            if ((TIFR2 & (1 << OCF2A)) && (TIMSK2 & (1 << OCIE2A))) {
+                TIFR2 = (1 << OCF2A);
+                runVector(TIMER2_COMPA_vect);
+            } else if ((TIFR2 & (1 << OCF2B)) && (TIMSK2 & (1 << OCIE2B))) {
+                TIFR2 = (1 << OCF2B);
+                runVector(TIMER2_COMPB_vect);
+            } else if ((ADCSRA.bits() & (1 << ADIF)) && (ADCSRA.bits() & (1 << ADIE))) {
+                ADCSRA.acknowledge();
+                runVector(ADC_vect);
+            } else {
+                break;
+            }
+        }
+    }
+
+    // Cycles until the running ADC conversion finishes, 0 if idle
+    uint64_t adcRemaining() {
+        return (adcBusy && adcDone > now) ? adcDone - now : 0;
+    }
+
+    void stepADC() {
+        if (adcBusy && now >= adcDone) {
+            adcBusy = false;
+            ADC = (uint16_t)htl_host::analogValue(adcChannel);
+            ADCSRA.complete();
+        }
+    }
+
+    uint8_t* eepromCell(const void* address) {
+        if (!eepromErased) {
+            memset(eeprom, 0xFF, sizeof(eeprom));
+            eepromErased = true;
+        }
+        return &eeprom[(uintptr_t)address & E2END];
+    }
+
+    HostPort& portOf(uint8_t pin) {
+        switch (digitalPinToPort(pin)) {
+            case PB: return PORTB;
+            case PC: return PORTC;
+            default: return PORTD;
+        }
+    }
+
+    uint8_t* ddrOf(uint8_t pin) {
+        switch (digitalPinToPort(pin)) {
+            case PB: return &DDRB;
+            case PC: return &DDRC;
+            default: return &DDRD;
+        }
+    }
+
+    // A line is only driven low if the pin is an output
+    bool driven(uint8_t pin) {
+        return (*ddrOf(pin) & digitalPinToBitMask(pin)) && !htl_host::pinLevel(pin);
+    }
+
+    uint16_t dataPattern() {
+        uint16_t lines = 0;
+        for (uint8_t pin = 0; pin < 10; pin++) {
+            if (driven(pin) || (htl_host::pwmActive(pin) && htl_host::pwmValue(pin) < 255)) {
+                lines |= (1 << pin);
+            }
+        }
+        return lines;
+    }
+
+    // The RGB LED is active low, brightness is the inverted duty cycle
+    uint32_t rgbPattern() {
+        uint32_t rgb = 0;
+        for (int c = 0; c < 3; c++) {
+            uint8_t pin = RGB_PINS[c];
+            uint8_t level = (*ddrOf(pin) & digitalPinToBitMask(pin)) ? 255 - htl_host::pwmValue(pin) : 0;
+            rgb = (rgb << 8) | level;
+        }
+        return rgb;
+    }
+
+    // VCD identifiers: D0-D12 are 'A' to 'M', the PWM duty of the RGB pins 'r', 'g', 'b', port stores 'w'
+    const char VCD_DUTY_IDS[3] = {'r', 'g', 'b'};
+    const char VCD_WRITE_ID = 'w';
+    const uint64_t VCD_TICKS_PER_CYCLE = 625; // 62.5 ns per cycle in the 100 ps time scale
+
+    char lineValue(uint8_t pin) {
+        if (pwmOn[pin]) {
+            return 'x';
+        }
+        if (!(*ddrOf(pin) & digitalPinToBitMask(pin))) {
+            return 'z';
+        }
+        return htl_host::pinLevel(pin) ? '1' : '0';
+    }
+
+    void vcdStamp() {
+        if (now != vcdTime) {
+            fprintf(vcd, "#%llu\n", (unsigned long long)(now * VCD_TICKS_PER_CYCLE));
+            vcdTime = now;
+        }
+    }
+
+    // Writes the lines that changed since the last call
+    void recordLines(bool all) {
+        for (uint8_t pin = 0; pin < 13; pin++) {
+            char value = lineValue(pin);
+            if (all || value != vcdLines[pin]) {
+                vcdStamp();
+                fprintf(vcd, "%c%c\n", value, 'A' + pin);
+                vcdLines[pin] = value;
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            int duty = htl_host::pwmValue(RGB_PINS[c]);
+            if (all || duty != vcdDuty[c]) {
+                vcdStamp();
+                fprintf(vcd, "r%d %c\n", duty, VCD_DUTY_IDS[c]);
+                vcdDuty[c] = duty;
+            }
+        }
+    }
+
+    // A port store or pinMode() of a display line, whether it changed a line or not
+    void recordWrite() {
+        if (vcd) {
+            vcdStamp();
+            fprintf(vcd, "1%c\n", VCD_WRITE_ID);
+        }
+    }
+
+    bool settled(const Window& w) {
+        return w.selected && now - w.patternSince >= (w.pattern ? SETTLE_CYCLES : SETTLE_BLANK_CYCLES);
+    }
+
+    // Called after every pin change, tracks which display shows which data for how long
+    void observe() {
+        uint16_t lines = dataPattern();
+        uint32_t rgb = rgbPattern();
+
+        for (int d = 0; d < 3; d++) {
+            Window& w = windows[d];
+            bool selected = driven(SELECT_PINS[d]);
+            uint32_t pattern = (d == 2) ? rgb : lines;
+
+            if (w.selected) {
+                displays[d].onCycles += now - lastObserve;
+                if (d == 2) {
+                    for (int c = 0; c < 3; c++) {
+                        rgbLevelCycles[c] += (now - lastObserve) * ((w.pattern >> (16 - 8 * c)) & 0xFF);
+                    }
+                }
+            }
+
+            if (w.selected != selected || w.pattern != pattern) {
+                if (settled(w)) {
+                    displays[d].lastPattern = w.pattern;
+                }
+                w.pattern = pattern;
+                w.patternSince = now;
+            }
+            w.selected = selected;
+        }
+        lastObserve = now;
+
+        if (trace) {
+            fprintf(trace, "%10.3f ms  sel=%c%c%c  data=", now / 16000.0,
+                    windows[0].selected ? 'H' : '-', windows[1].selected ? 'S' : '-', windows[2].selected ? 'R' : '-');
+            for (int i = 9; i >= 0; i--) {
+                fputc((lines & (1 << i)) ? '1' : '0', trace);
+            }
+            fprintf(trace, "  rgb=%06x\n", (unsigned)rgb);
+        }
+        if (vcd) {
+            recordLines(false);
+        }
+    }
+}
+
+HostADCSRA& HostADCSRA::operator=(uint8_t v) {
+    bool wasEnabled = value & (1 << ADEN);
+    uint8_t keep = value & ((1 << ADIF) | (1 << ADSC)); // Writing zero does not clear these
+    if (v & (1 << ADIF)) {
+        keep &= ~(1 << ADIF);
+    }
+    value = (uint8_t)((v & ~(1 << ADIF)) | keep);
+
+    if (!(value & (1 << ADEN))) {
+        // Disabling the ADC aborts a conversion
+        value &= ~(1 << ADSC);
+        adcBusy = false;
+    } else if ((value & (1 << ADSC)) && !adcBusy) {
+        static const uint8_t dividers[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+        uint32_t clocks = wasEnabled ? 13 : 25;
+        adcChannel = ADMUX & 0x0F;
+        adcDone = now + (uint64_t)clocks * dividers[value & 0x07];
+        adcBusy = true;
+    }
+    return *this;
+}
+
+HostADCSRA::operator uint8_t() const {
+    htl_host::advance(1);
+    return value;
+}
+
+void HostADCSRA::complete() {
+    value = (uint8_t)((value & ~(1 << ADSC)) | (1 << ADIF));
+}
+
+void HostADCSRA::acknowledge() {
+    value &= ~(1 << ADIF);
+}
+
+HostTCNT1& HostTCNT1::operator=(uint16_t v) {
+    value = v;
+    since = htl_host::cycles();
+    return *this;
+}
+
+HostTCNT1::operator uint16_t() const {
+    static const uint16_t dividers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+    uint16_t divider = dividers[TCCR1B & 0x07];
+    if (!divider) {
+        return value; // Stopped or clocked from T1, which the model does not drive
+    }
+    return (uint16_t)(value + (htl_host::cycles() - since) / divider);
+}
+
+HostPort& HostPort::operator=(uint8_t v) {
+    counters.portStores++;
+    htl_host::advance(htl_host::COST_PORT_STORE);
+    if (port != PC) {
+        recordWrite();
+    }
+    if (v != value) {
+        value = v;
+        htl_host::portWritten(port);
+    }
+    return *this;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    counters.pinModes++;
+    htl_host::advance(htl_host::COST_PIN_MODE);
+    if (pin > 19) {
+        return;
+    }
+    uint8_t mask = digitalPinToBitMask(pin);
+    if (mode == OUTPUT) {
+        *ddrOf(pin) |= mask;
+    } else {
+        *ddrOf(pin) &= ~mask;
+        if (mode == INPUT_PULLUP) {
+            portOf(pin) |= mask;
+        }
+    }
+    if (pin <= 12) {
+        recordWrite();
+        observe();
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    counters.digitalWrites++;
+    htl_host::advance(htl_host::COST_DIGITAL_WRITE - htl_host::COST_PORT_STORE);
+    if (pin > 19) {
+        return;
+    }
+    pwmOn[pin] = false; // digitalWrite() disconnects the pin from its timer
+    uint8_t mask = digitalPinToBitMask(pin);
+    HostPort& port = portOf(pin);
+    uint8_t oldSREG = SREG;
+    cli();
+    if (val == LOW) {
+        port &= ~mask;
+    } else {
+        port |= mask;
+    }
+    SREG = oldSREG;
+    counters.portStores--; // Counted as digitalWrite
+}
+
+int digitalRead(uint8_t pin) {
+    htl_host::advance(htl_host::COST_DIGITAL_READ);
+    return htl_host::pinLevel(pin);
+}
+
+void analogWrite(uint8_t pin, int val) {
+    counters.analogWrites++;
+    htl_host::advance(htl_host::COST_ANALOG_WRITE);
+    if (pin > 19) {
+        return;
+    }
+    if (val <= 0 || val >= 255 || (pin != 3 && pin != 5 && pin != 6 && pin != 9 && pin != 10 && pin != 11)) {
+        // Like the core: full scale and non-PWM pins are plain digital writes
+        digitalWrite(pin, val < 128 ? LOW : HIGH);
+        counters.digitalWrites--;
+        return;
+    }
+    pwm[pin] = (uint8_t)val;
+    pwmOn[pin] = true;
+    observe();
+}
+
+int analogRead(uint8_t pin) {
+    counters.analogReads++;
+    htl_host::advance(htl_host::COST_ANALOG_READ);
+    return htl_host::analogValue(pin);
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+    htl_host::advance(htl_host::COST_EEPROM_READ);
+    return *eepromCell(address);
+}
+
+void eeprom_read_block(void* destination, const void* source, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        ((uint8_t*)destination)[i] = eeprom_read_byte((const uint8_t*)source + i);
+    }
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+    htl_host::advance(htl_host::COST_EEPROM_WRITE);
+    *eepromCell(address) = value;
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    if (eeprom_read_byte(address) != value) {
+        eeprom_write_byte(address, value);
+    }
+}
+
+void eeprom_update_block(const void* source, void* destination, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        eeprom_update_byte((uint8_t*)destination + i, ((const uint8_t*)source)[i]);
+    }
+}
+
+unsigned long millis(void) {
+    htl_host::advance(htl_host::COST_MILLIS);
+    return (unsigned long)(now / (F_CPU / 1000));
+}
+
+unsigned long micros(void) {
+    htl_host::advance(htl_host::COST_MICROS);
+    return (unsigned long)(now / (F_CPU / 1000000));
+}
+
+void delay(unsigned long ms) {
+    htl_host::advanceTo(htl_host::cycles() + (uint64_t)ms * (F_CPU / 1000));
+}
+
+void delayMicroseconds(unsigned int us) {
+    htl_host::advanceTo(htl_host::cycles() + (uint64_t)us * (F_CPU / 1000000));
+}
+
+long random(long howbig) {
+    return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+    srand((unsigned int)seed);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+    if (value < 0 && base == DEC) {
+        s = "-" + String((unsigned long)-value, base).s;
+    } else {
+        s = String((unsigned long)value, base).s;
+    }
+}
+
+String::String(unsigned long value, unsigned char base) {
+    char buf[33];
+    int i = 32;
+    buf[i] = 0;
+    do {
+        int digit = value % base;
+        buf[--i] = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value);
+    s = &buf[i];
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return print(buf);
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    (void)baud;
+}
+
+int HardwareSerial::available() {
+    pollSerial();
+    return serialCount;
+}
+
+int HardwareSerial::read() {
+    if (available() == 0) {
+        return -1;
+    }
+    uint8_t c = serialRx[serialHead];
+    serialHead = (serialHead + 1) % SERIAL_RX_BUFFER_SIZE;
+    serialCount--;
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return available() ? serialRx[serialHead] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialFd < 0) {
+        return fwrite(buffer, 1, size, stdout);
+    }
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(serialFd, buffer + done, size - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break; // Nobody reading, the bytes are lost like on an unconnected TX line
+        }
+        done += n;
+    }
+    return size;
+}
+
+namespace htl_host {
+
+    bool loadEEPROM(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) {
+            return false;
+        }
+        eepromCell(0);
+        size_t n = fread(eeprom, 1, sizeof(eeprom), f);
+        fclose(f);
+        return n > 0;
+    }
+
+    bool saveEEPROM(const char* path) {
+        FILE* f = fopen(path, "wb");
+        if (!f) {
+            return false;
+        }
+        size_t n = fwrite(eepromCell(0), 1, sizeof(eeprom), f);
+        return fclose(f) == 0 && n == sizeof(eeprom);
+    }
+
+    void attachSerial(int fd) {
+        serialFd = fd;
+        serialHead = 0;
+        serialCount = 0;
+    }
+
+    void reset() {
+        now = 0;
+        lastObserve = 0;
+        counters = Stats();
+        for (int d = 0; d < 3; d++) {
+            displays[d] = DisplayStats();
+            windows[d] = Window();
+            rgbLevelCycles[d] = 0;
+        }
+        for (int i = 0; i < 20; i++) {
+            pwm[i] = 0;
+            pwmOn[i] = false;
+        }
+        for (int i = 0; i < 6; i++) {
+            scripts[i].clear();
+            analogNow[i] = (i == 1) ? 1023 : 0; // Pull-up on the switch ladder
+        }
+        PORTB = 0;
+        PORTC = 0;
+        PORTD = 0;
+        DDRB = DDRC = DDRD = 0;
+        SREG = 0x80;
+        TCCR2A = TCCR2B = OCR2A = OCR2B = TCNT2 = TIMSK2 = 0;
+        TIFR2.clearAll();
+        timer2Prescale = 0;
+        TCCR1A = TCCR1B = 0;
+        TCNT1.clearAll();
+        ADMUX = 0;
+        ADCSRA.clearAll();
+        ADC = 0;
+        adcBusy = false;
+        inInterrupt = false;
+        SMCR = PCICR = PCMSK0 = PCMSK1 = PCMSK2 = 0;
+        counters = Stats();
+    }
+
+    uint64_t cycles() {
+        return now;
+    }
+
+    void advance(uint32_t n) {
+        uint64_t remaining = n;
+        while (remaining) {
+            // Step to the next peripheral event, so no interrupt is lost during long delays
+            uint64_t step = remaining;
+            uint64_t timer2 = timer2Remaining();
+            if (timer2 && timer2 < step) {
+                step = timer2;
+            }
+            uint64_t adc = adcRemaining();
+            if (adc && adc < step) {
+                step = adc;
+            }
+            now += step;
+            remaining -= step;
+            stepTimer2(step);
+            stepADC();
+            dispatchInterrupts();
+        }
+    }
+
+    void advanceTo(uint64_t target) {
+        // Interrupts during the wait do not extend it, like the micros() based delay() of the core
+        while (now < target) {
+            uint64_t n = target - now;
+            advance(n > 0x7FFFFFFF ? 0x7FFFFFFF : (uint32_t)n);
+        }
+    }
+
+    void sleep() {
+        // Nothing could wake the CPU with interrupts disabled; return instead of hanging
+        if (!(SREG & 0x80) || inInterrupt) {
+            return;
+        }
+        counters.wakeups++;
+
+        // A received byte wakes at once, otherwise the next vector or the millis() tick
+        int received = serialCount;
+        pollSerial();
+        if (serialCount > received) {
+            return;
+        }
+        uint64_t tick = (now / TIMER0_TICK_CYCLES + 1) * TIMER0_TICK_CYCLES;
+        unsigned long vectors = vectorsRun;
+        while (vectorsRun == vectors && now < tick) {
+            uint64_t step = tick - now;
+            uint64_t timer2 = timer2Remaining();
+            if (timer2 && timer2 < step) {
+                step = timer2;
+            }
+            uint64_t adc = adcRemaining();
+            if (adc && adc < step) {
+                step = adc;
+            }
+            now += step;
+            counters.sleepCycles += step; // The vector that ends the sleep runs awake
+            stepTimer2(step);
+            stepADC();
+            dispatchInterrupts();
+        }
+    }
+
+    HostPort* portRegister(uint8_t port) {
+        switch (port) {
+            case PB: return &PORTB;
+            case PC: return &PORTC;
+            case PD: return &PORTD;
+            default: return NULL;
+        }
+    }
+
+    void portWritten(uint8_t port) {
+        if (port != PC) {
+            observe();
+        }
+    }
+
+    uint8_t pinLevel(uint8_t pin) {
+        if (pin > 19) {
+            return LOW;
+        }
+        return (portOf(pin) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+    }
+
+    uint8_t pwmValue(uint8_t pin) {
+        if (pin > 19) {
+            return 0;
+        }
+        if (pwmOn[pin]) {
+            return pwm[pin];
+        }
+        return pinLevel(pin) ? 255 : 0;
+    }
+
+    bool pwmActive(uint8_t pin) {
+        return pin <= 19 && pwmOn[pin];
+    }
+
+    void setAnalog(uint8_t pin, int value) {
+        if (pin >= A0 && pin <= A5) {
+            scripts[pin - A0].clear();
+            analogNow[pin - A0] = value;
+        }
+    }
+
+    void scriptAnalog(uint8_t pin, unsigned long ms, int value) {
+        if (pin >= A0 && pin <= A5) {
+            scripts[pin - A0].push_back(std::make_pair(ms, value));
+        }
+    }
+
+    int analogValue(uint8_t pin) {
+        if (pin < A0) {
+            pin += A0; // analogRead(0) reads A0 like on the Uno
+        }
+        if (pin > A5) {
+            return 0;
+        }
+        int value = analogNow[pin - A0];
+        unsigned long ms = (unsigned long)(now / (F_CPU / 1000));
+        for (size_t i = 0; i < scripts[pin - A0].size(); i++) {
+            if (scripts[pin - A0][i].first <= ms) {
+                value = scripts[pin - A0][i].second;
+            }
+        }
+        return constrain(value, 0, 1023);
+    }
+
+    int switchLevel(int state) {
+        // Typical ladder voltages between the default thresholds 500/700/900
+        switch (state) {
+            case 1: return 600; // Both switches
+            case 2: return 800; // S2
+            case 3: return 300; // S3
+            default: return 1023; // None, pulled up
+        }
+    }
+
+    const Stats& stats() {
+        return counters;
+    }
+
+    const DisplayStats& display(int mode) {
+        return displays[mode];
+    }
+
+    void setTrace(FILE* out) {
+        trace = out;
+    }
+
+    void recordVCD(FILE* out) {
+        if (vcd) {
+            // The closing time stamp gives the length of the last state
+            fprintf(vcd, "#%llu\n", (unsigned long long)(now * VCD_TICKS_PER_CYCLE));
+            fflush(vcd);
+        }
+        vcd = out;
+        if (!vcd) {
+            return;
+        }
+
+        fprintf(vcd, "$version HTL_onboard host model $end\n");
+        fprintf(vcd, "$timescale 100 ps $end\n");
+        fprintf(vcd, "$scope module htl_uno $end\n");
+        for (uint8_t pin = 0; pin < 13; pin++) {
+            const char* suffix = "";
+            for (int d = 0; d < 3; d++) {
+                if (SELECT_PINS[d] == pin) {
+                    suffix = d == 0 ? "_HEX" : (d == 1 ? "_STRIPE" : "_RGB");
+                }
+            }
+            fprintf(vcd, "$var wire 1 %c D%u%s $end\n", 'A' + pin, pin, suffix);
+        }
+        for (int c = 0; c < 3; c++) {
+            fprintf(vcd, "$var real 64 %c PWM_D%u $end\n", VCD_DUTY_IDS[c], RGB_PINS[c]);
+        }
+        fprintf(vcd, "$var event 1 %c write $end\n", VCD_WRITE_ID);
+        fprintf(vcd, "$upscope $end\n$enddefinitions $end\n");
+        fprintf(vcd, "#%llu\n$dumpvars\n", (unsigned long long)(now * VCD_TICKS_PER_CYCLE));
+        vcdTime = now;
+        recordLines(true);
+        fprintf(vcd, "$end\n");
+    }
+
+    void report(FILE* out) {
+        observe();
+        for (int d = 0; d < 3; d++) {
+            if (settled(windows[d])) {
+                displays[d].lastPattern = windows[d].pattern;
+            }
+        }
+
+        fprintf(out, "time        %.3f ms (%llu cycles)\n", now / 16000.0, (unsigned long long)now);
+        for (int d = 0; d < 3; d++) {
+            fprintf(out, "%-8s    on %5.1f%%  ", DISPLAY_NAMES[d], now ? 100.0 * displays[d].onCycles / now : 0.0);
+            uint32_t pattern = displays[d].lastPattern;
+            if (d == 2) {
+                fprintf(out, "rgb=%u,%u,%u", (unsigned)(pattern >> 16), (unsigned)((pattern >> 8) & 0xFF), (unsigned)(pattern & 0xFF));
+                uint64_t on = (displays[d].onCycles >= SETTLE_BLANK_CYCLES) ? displays[d].onCycles : 0; // Not just begin()
+                fprintf(out, "  avg=%u,%u,%u\n", (unsigned)(on ? rgbLevelCycles[0] / on : 0),
+                        (unsigned)(on ? rgbLevelCycles[1] / on : 0), (unsigned)(on ? rgbLevelCycles[2] / on : 0));
+            } else {
+                fprintf(out, "lines=");
+                for (int i = 9; i >= 0; i--) {
+                    fputc((pattern & (1 << i)) ? '1' : '0', out);
+                }
+                fputc('\n', out);
+            }
+        }
+        fprintf(out, "core calls  pinMode=%lu digitalWrite=%lu analogWrite=%lu analogRead=%lu portStores=%lu\n",
+                counters.pinModes, counters.digitalWrites, counters.analogWrites, counters.analogReads, counters.portStores);
+        if (counters.wakeups) {
+            uint64_t active = now - counters.sleepCycles;
+            fprintf(out, "sleep       asleep %5.1f%%  wakeups=%lu  active=%llu cycles (%llu per wakeup)\n",
+                    now ? 100.0 * counters.sleepCycles / now : 0.0, counters.wakeups, (unsigned long long)active,
+                    (unsigned long long)(active / counters.wakeups));
+        }
+    }
+}
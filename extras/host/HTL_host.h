@@ -0,0 +1,95 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef HTL_HOST_H
+#define HTL_HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+class HostPort;
+
+/**
+ * @brief Control surface of the host board model.
+ * 
+ * The model keeps a virtual clock in CPU cycles of a 16 MHz ATmega328P. Every core call
+ * (digitalWrite, port store, analogRead, ...) is charged with its approximate cost on the
+ * real board, delay() advances the clock directly. The library's own code runs natively and is
+ * not charged, Timer1 counts the same virtual clock. Analog inputs follow a script of
+ * (time, value) steps, so pot and switch input can be replayed deterministically.
+ */
+namespace htl_host {
+
+    // Approximate cost of the core calls in CPU cycles with the AVR core of the Uno
+    const uint32_t COST_PIN_MODE = 56;
+    const uint32_t COST_DIGITAL_WRITE = 60;
+    const uint32_t COST_DIGITAL_READ = 52;
+    const uint32_t COST_ANALOG_WRITE = 80;
+    const uint32_t COST_ANALOG_READ = 1792; // 13 ADC clocks at prescaler 128 plus call overhead
+    const uint32_t COST_PORT_STORE = 6;
+    const uint32_t COST_MILLIS = 28;
+    const uint32_t COST_MICROS = 44;
+    const uint32_t COST_EEPROM_READ = 12; // Per byte, the CPU halts 4 cycles for each EEPROM read
+    const uint32_t COST_EEPROM_WRITE = 54400; // Per changed byte, erase and write take 3.4 ms
+
+    struct Stats {
+        unsigned long pinModes;
+        unsigned long digitalWrites;
+        unsigned long analogWrites;
+        unsigned long analogReads;
+        unsigned long portStores;
+        unsigned long wakeups; // sleep_cpu() calls with sleep enabled
+        uint64_t sleepCycles; // Cycles spent asleep, without the vectors that woke the CPU
+    };
+
+    struct DisplayStats {
+        uint64_t onCycles; // Cycles the select line was active
+        uint32_t lastPattern; // Data lines (bit i = pin i low) or packed RGB colour shown in the last active window
+    };
+
+    void reset();
+    uint64_t cycles();
+    void advance(uint32_t cycles);
+    void advanceTo(uint64_t cycle);
+    void sleep(); // Idle sleep: skips to the next interrupt, called by sleep_cpu()
+
+    HostPort* portRegister(uint8_t port);
+    void portWritten(uint8_t port);
+
+    uint8_t pinLevel(uint8_t pin);
+    uint8_t pwmValue(uint8_t pin);
+    bool pwmActive(uint8_t pin);
+
+    void setAnalog(uint8_t pin, int value);
+    void scriptAnalog(uint8_t pin, unsigned long ms, int value);
+    int analogValue(uint8_t pin);
+    int switchLevel(int state);
+
+    const Stats& stats();
+    const DisplayStats& display(int mode);
+
+    bool loadEEPROM(const char* path); // EEPROM contents from an image file, false if it does not exist
+    bool saveEEPROM(const char* path);
+
+    void attachSerial(int fd); // Serial reads from and writes to fd (non-blocking), -1 for stdout only
+    void setTrace(FILE* out);
+    void recordVCD(FILE* out); // Writes every change of D0-D12 and every port store as a VCD waveform, NULL ends it
+    void report(FILE* out);
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// Host replacement for <avr/eeprom.h>: the 1 KB EEPROM of the ATmega328P. It survives
+// htl_host::reset() like the real EEPROM survives a reset, the runner loads and saves it with -e.
+
+#ifndef HTL_HOST_AVR_EEPROM_H
+#define HTL_HOST_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x3FF
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+void eeprom_read_block(void* destination, const void* source, size_t size);
+void eeprom_write_byte(uint8_t* address, uint8_t value);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+void eeprom_update_block(const void* source, void* destination, size_t size);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Host replacement for <avr/interrupt.h>
+
+#ifndef HTL_HOST_AVR_INTERRUPT_H
+#define HTL_HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define cli() (SREG &= (uint8_t)~0x80)
+#define sei() (SREG |= (uint8_t)0x80)
+
+// Interrupt vectors are plain functions, the board model calls them when the peripheral fires
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+#define EMPTY_INTERRUPT(vector) ISR(vector) {}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Host replacement for <avr/io.h>: virtual I/O registers of the ATmega328P
+
+#ifndef HTL_HOST_AVR_IO_H
+#define HTL_HOST_AVR_IO_H
+
+#include <stdint.h>
+
+/**
+ * @brief Virtual output port register.
+ * 
+ * Behaves like a volatile uint8_t, but every store is charged to the virtual clock
+ * and forwarded to the board model so pin changes can be observed.
+ */
+class HostPort {
+public:
+    explicit HostPort(uint8_t port) : port(port), value(0) {}
+
+    HostPort& operator=(uint8_t v);
+    HostPort& operator|=(uint8_t v) { return *this = (uint8_t)(value | v); }
+    HostPort& operator&=(uint8_t v) { return *this = (uint8_t)(value & v); }
+    HostPort& operator^=(uint8_t v) { return *this = (uint8_t)(value ^ v); }
+    operator uint8_t() const { return value; }
+
+private:
+    HostPort(const HostPort&);
+    HostPort& operator=(const HostPort&);
+
+    uint8_t port;
+    uint8_t value;
+};
+
+// The library writes frames through HostPort instead of a volatile uint8_t
+#define HTL_PORT_T HostPort
+
+extern HostPort PORTB;
+extern HostPort PORTC;
+extern HostPort PORTD;
+extern uint8_t DDRB, DDRC, DDRD;
+extern uint8_t SREG;
+
+// Interrupt flag register: like on the AVR, writing a one clears the flag
+class HostFlags {
+public:
+    HostFlags() : value(0) {}
+
+    HostFlags& operator=(uint8_t v) { value &= (uint8_t)~v; return *this; }
+    operator uint8_t() const { return value; }
+
+    void raise(uint8_t bits) { value |= bits; } // Set by the peripheral
+    void clearAll() { value = 0; }
+
+private:
+    HostFlags(const HostFlags&);
+    HostFlags& operator=(const HostFlags&);
+
+    uint8_t value;
+};
+
+// Sleep mode control, see avr/sleep.h
+extern uint8_t SMCR;
+
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+// Pin change interrupts, masks only: the model has no input levels that could change
+extern uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2;
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+
+// Timer2, simulated in CTC and normal mode with compare A and B
+extern uint8_t TCCR2A, TCCR2B, OCR2A, OCR2B, TCNT2, TIMSK2;
+extern HostFlags TIFR2;
+
+#define WGM20 0
+#define WGM21 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+
+/**
+ * @brief Virtual Timer1 counter.
+ * 
+ * Only counts up with the prescaler of TCCR1B, like the normal mode, so sketches can time code
+ * in CPU cycles. Select the prescaler before writing the counter.
+ */
+class HostTCNT1 {
+public:
+    HostTCNT1() : value(0), since(0) {}
+
+    HostTCNT1& operator=(uint16_t v);
+    operator uint16_t() const;
+    void clearAll() { value = 0; since = 0; }
+
+private:
+    HostTCNT1(const HostTCNT1&);
+    HostTCNT1& operator=(const HostTCNT1&);
+
+    uint16_t value; // Written value
+    uint64_t since; // Cycle of the write
+};
+
+// Timer1, only as a free running counter
+extern uint8_t TCCR1A, TCCR1B;
+extern HostTCNT1 TCNT1;
+
+#define WGM10 0
+#define CS10 0
+#define CS11 1
+#define CS12 2
+
+/**
+ * @brief Virtual ADC control and status register A.
+ * 
+ * Setting ADSC with ADEN starts a conversion of the channel selected in ADMUX, the result is
+ * stored in ADC after 13 ADC clocks (25 for the first one). Writing a one to ADIF clears it.
+ */
+class HostADCSRA {
+public:
+    HostADCSRA() : value(0) {}
+
+    HostADCSRA& operator=(uint8_t v);
+    HostADCSRA& operator|=(uint8_t v) { return *this = (uint8_t)(value | v); }
+    HostADCSRA& operator&=(uint8_t v) { return *this = (uint8_t)(value & v); }
+    operator uint8_t() const; // Charged with one cycle, so polling ADSC lets the conversion finish
+    uint8_t bits() const { return value; }
+
+    void complete(); // Conversion finished: ADSC cleared, ADIF set
+    void acknowledge(); // Interrupt vector executed: ADIF cleared
+    void clearAll() { value = 0; }
+
+private:
+    HostADCSRA(const HostADCSRA&);
+    HostADCSRA& operator=(const HostADCSRA&);
+
+    uint8_t value;
+};
+
+// ADC, simulated in single conversion mode
+extern uint8_t ADMUX;
+extern HostADCSRA ADCSRA;
+extern uint16_t ADC;
+#define ADCW ADC
+
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+
+#endif
@@ -0,0 +1,42 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+// Host replacement for <avr/sleep.h>. Every sleep mode is modelled as idle: the clock skips to
+// the next interrupt (Timer2, ADC, the Timer0 tick of millis() or a received byte), see
+// htl_host::sleep().
+
+#ifndef HTL_HOST_AVR_SLEEP_H
+#define HTL_HOST_AVR_SLEEP_H
+
+#include <avr/io.h>
+#include "HTL_host.h"
+
+#define SLEEP_MODE_IDLE (0 << SM0)
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (2 << SM0)
+#define SLEEP_MODE_PWR_SAVE (3 << SM0)
+#define SLEEP_MODE_STANDBY (6 << SM0)
+#define SLEEP_MODE_EXT_STANDBY (7 << SM0)
+
+#define set_sleep_mode(mode) (SMCR = (uint8_t)((SMCR & ~((1 << SM0) | (1 << SM1) | (1 << SM2))) | (mode)))
+#define sleep_enable() (SMCR |= (uint8_t)(1 << SE))
+#define sleep_disable() (SMCR &= (uint8_t)~(1 << SE))
+
+// The SLEEP instruction does nothing unless SE is set
+#define sleep_cpu() do { if (SMCR & (1 << SE)) htl_host::sleep(); } while (0)
+
+#endif
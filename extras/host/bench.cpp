@@ -0,0 +1,176 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Cycle benchmark of the multiplex hot path on the host board model.
+//
+// Usage: bench [-n calls]
+//
+// Prints one CSV row per measured call and output path (port registers or per-pin):
+//   name,output,calls,min_cycles,avg_cycles,max_cycles,max_us,max_rate_hz,host_min_ns,host_median_ns
+// max_rate_hz is the number of back-to-back calls per second at 16 MHz. The summary
+// rows "frame" give the cost of one refresh of all three displays.
+//
+// The cycles are those charged by the board model for core calls, port stores and
+// interrupt entry, see HTL_host.h. The library's own code runs natively and is only in the
+// host_ columns, which time each call including the model and vary with the host, so
+// compare them between versions on the same machine only. The Multiplexing_Benchmark
+// example measures the same calls in real CPU cycles on the board.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "Arduino.h"
+#include "HTL_onboard.h"
+
+struct Result {
+    unsigned long calls;
+    uint64_t minCycles;
+    uint64_t maxCycles;
+    uint64_t totalCycles;
+    uint64_t hostMinNs;
+    uint64_t hostMedianNs;
+};
+
+static unsigned long benchCalls = 256;
+
+// Board with a given content, every case starts from a fresh model and begin()
+static void prepare(HTL_onboard& onboard, bool fast) {
+    htl_host::reset();
+    onboard.begin();
+    onboard.setFastOutput(fast);
+}
+
+template <typename Call>
+static Result measure(HTL_onboard& onboard, Call call) {
+    Result r = {0, ~(uint64_t)0, 0, 0, 0, 0};
+    std::vector<uint64_t> hostNs;
+    hostNs.reserve(benchCalls);
+    for (unsigned long i = 0; i < benchCalls; i++) {
+        // Leave the multiplex interval and string delay behind before each call
+        htl_host::advance(2 * (F_CPU / 1000));
+
+        uint64_t start = htl_host::cycles();
+        std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+        call(onboard);
+        std::chrono::steady_clock::time_point hostEnd = std::chrono::steady_clock::now();
+        uint64_t cycles = htl_host::cycles() - start;
+        hostNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(hostEnd - hostStart).count());
+
+        r.calls++;
+        r.totalCycles += cycles;
+        if (cycles < r.minCycles) r.minCycles = cycles;
+        if (cycles > r.maxCycles) r.maxCycles = cycles;
+    }
+
+    // The minimum and median are robust against preemption of the host process
+    std::sort(hostNs.begin(), hostNs.end());
+    r.hostMinNs = hostNs.front();
+    r.hostMedianNs = hostNs[hostNs.size() / 2];
+    return r;
+}
+
+static void printRow(const char* name, bool fast, const Result& r) {
+    printf("%s,%s,%lu,%llu,%llu,%llu,%.2f,%.0f,%llu,%llu\n", name, fast ? "port" : "pin", r.calls,
+           (unsigned long long)r.minCycles, (unsigned long long)(r.totalCycles / r.calls),
+           (unsigned long long)r.maxCycles, r.maxCycles * 1e6 / F_CPU,
+           r.maxCycles ? (double)F_CPU / r.maxCycles : 0.0,
+           (unsigned long long)r.hostMinNs, (unsigned long long)r.hostMedianNs);
+}
+
+// One slot of the given display content, measured through multiplexTick() and updateMultiplex()
+static Result benchSlot(const char* name, bool fast, int mode, void (*content)(HTL_onboard&)) {
+    const int modes[1] = {mode};
+    char label[48];
+
+    HTL_onboard onboard;
+    prepare(onboard, fast);
+    onboard.setModesMultiplex(modes, 1);
+    content(onboard);
+    Result tick = measure(onboard, [](HTL_onboard& o) { o.multiplexTick(); });
+    snprintf(label, sizeof(label), "slot_%s", name);
+    printRow(label, fast, tick);
+
+    Result update = measure(onboard, [](HTL_onboard& o) { o.updateMultiplex(); });
+    snprintf(label, sizeof(label), "update_%s", name);
+    printRow(label, fast, update);
+    return tick;
+}
+
+static void benchSuite(bool fast) {
+    Result hex = benchSlot("hex", fast, MODE_HEX, [](HTL_onboard& o) { o.setHexMode(HEX_MODE_HEX); o.setHexNumber(-0x1A); });
+    benchSlot("dec", fast, MODE_HEX, [](HTL_onboard& o) { o.setHexMode(HEX_MODE_DEC); o.setHexNumber(-17); });
+    benchSlot("char", fast, MODE_HEX, [](HTL_onboard& o) { o.setHexMode(HEX_MODE_CHAR); o.setChar('x'); });
+    benchSlot("string", fast, MODE_HEX, [](HTL_onboard& o) { o.setString("HTL Uno"); o.setHexMode(HEX_MODE_STRING); });
+    Result stripe = benchSlot("bin", fast, MODE_STRIPE, [](HTL_onboard& o) { o.setStripeMode(STRIPE_MODE_BIN); o.setLedStripeValue(0x2AA); });
+    benchSlot("prog", fast, MODE_STRIPE, [](HTL_onboard& o) { o.setStripeMode(STRIPE_MODE_PROG); o.setLedStripeValue(7); });
+    benchSlot("gray", fast, MODE_STRIPE, [](HTL_onboard& o) {
+        const uint8_t levels[10] = {255, 200, 160, 128, 96, 64, 32, 16, 8, 0};
+        o.setStripeMode(STRIPE_MODE_GRAY);
+        o.setStripeLevels(levels);
+    });
+    Result rgb = benchSlot("rgb", fast, MODE_RGB, [](HTL_onboard& o) { o.setRGB_Multiplex(255, 128, 0); });
+
+    // A full refresh of all three displays is one slot of each
+    Result frame = {1, hex.minCycles + stripe.minCycles + rgb.minCycles, hex.maxCycles + stripe.maxCycles + rgb.maxCycles,
+                    hex.totalCycles / hex.calls + stripe.totalCycles / stripe.calls + rgb.totalCycles / rgb.calls,
+                    hex.hostMinNs + stripe.hostMinNs + rgb.hostMinNs,
+                    hex.hostMedianNs + stripe.hostMedianNs + rgb.hostMedianNs};
+    printRow("frame", fast, frame);
+
+    HTL_onboard onboard;
+    prepare(onboard, fast);
+    printRow("writeChar", fast, measure(onboard, [](HTL_onboard& o) { o.writeChar('x'); }));
+    printRow("writeHex", fast, measure(onboard, [](HTL_onboard& o) { o.writeHex(0x1A); }));
+    printRow("writeBinary", fast, measure(onboard, [](HTL_onboard& o) { o.writeBinary(0x2AA); }));
+    printRow("setMode", fast, measure(onboard, [](HTL_onboard& o) { o.setMode(MODE_HEX, true); }));
+    printRow("setRGB", fast, measure(onboard, [](HTL_onboard& o) { o.setRGB(255, 128, 0); }));
+    printRow("readSwitchState", fast, measure(onboard, [](HTL_onboard& o) { o.readSwitchState(); }));
+    printRow("readPot", fast, measure(onboard, [](HTL_onboard& o) { o.readPot(); }));
+
+    // The setters encode the back frame: glyphs, port values, color correction and bit planes
+    printRow("setHexNumber", fast, measure(onboard, [](HTL_onboard& o) { o.setHexNumber(-0x1A); }));
+    printRow("setLedStripeValue", fast, measure(onboard, [](HTL_onboard& o) { o.setLedStripeValue(0x2AA); }));
+    printRow("setRGB_Multiplex", fast, measure(onboard, [](HTL_onboard& o) { o.setRGB_Multiplex(255, 128, 0); }));
+    onboard.setGammaCorrection(true);
+    printRow("setRGB_Multiplex_gamma", fast, measure(onboard, [](HTL_onboard& o) { o.setRGB_Multiplex(255, 128, 0); }));
+    onboard.setStripeMode(STRIPE_MODE_GRAY);
+    printRow("setStripeLevel", fast, measure(onboard, [](HTL_onboard& o) { o.setStripeLevel(3, 128); }));
+    printRow("storeRawFrame", fast, measure(onboard, [](HTL_onboard& o) { o.storeRawFrame(0x7E, true, false, 0x155, 255, 128, 0); }));
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc && atol(argv[i + 1]) > 0) {
+            benchCalls = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [-n calls]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("name,output,calls,min_cycles,avg_cycles,max_cycles,max_us,max_rate_hz,host_min_ns,host_median_ns\n");
+#if HTL_FAST_IO
+    benchSuite(true);
+#endif
+    benchSuite(false);
+    return 0;
+}
@@ -0,0 +1,218 @@
+# Remote control of an HTL Uno running HTL_onboardProtocol, e.g. the Serial_Protocol example.
+#
+# Usage: htl_remote.py PORT [-b baud] [-w seconds] [-r retries] command [args] [command [args] ...]
+#        htl_remote.py PORT [-b baud] [-w seconds] --stream SECONDS [--rate FPS]
+#
+# All commands of one call go out as one frame and take effect in the same multiplex slot:
+#   hex N              setHexNumber(N), N may be given as 0x1A
+#   char C             setChar(C)
+#   string TEXT        setString(TEXT), up to 32 characters
+#   stripe N           setLedStripeValue(N)
+#   rgb R G B          setRGB_Multiplex(R, G, B)
+#   modes hex,stripe,rgb   setModesMultiplex() with the listed displays
+#   interval MS        setMultiplexInterval(MS)
+#   hexmode hex|dec|char|string|pageddec|pagedhex
+#   stripemode bin|prog|gray
+#   read               prints the potentiometer value and the switch state
+#   stats              prints the streamed, dropped and late display frames
+#
+# --stream sends a test pattern as whole display frames (a counter on the HEX display, a
+# running LED and a color wheel) at --rate frames per second, then prints the statistics.
+# stream_frame() builds such frames for own dashboards.
+#
+# PORT is the serial port of the board (/dev/ttyACM0, ...) or the pseudo terminal that an
+# example prints when it runs on the host model with -S. Boards that reset when the port is
+# opened need -w 2. Exits with 1 if the board does not answer or reports an error.
+
+import argparse
+import os
+import select
+import sys
+import termios
+import time
+import tty
+
+SOF = 0xA5
+MAX_PAYLOAD = 48
+
+COMMANDS = {
+    # name: (id, argument parser)
+    "hex": (0x01, lambda a: int16(a[0])),
+    "char": (0x02, lambda a: bytes([ord(a[0][0])])),
+    "string": (0x03, lambda a: bytes([len(a[0].encode()[:32])]) + a[0].encode()[:32]),
+    "stripe": (0x04, lambda a: int16(a[0])),
+    "rgb": (0x05, lambda a: bytes(int(v, 0) & 0xFF for v in a[:3])),
+    "modes": (0x06, lambda a: bytes([sum(1 << ["hex", "stripe", "rgb"].index(m) for m in a[0].split(","))])),
+    "interval": (0x07, lambda a: int16(a[0])),
+    "hexmode": (0x08, lambda a: bytes([["hex", "dec", "char", "string", "pageddec", "pagedhex"].index(a[0])])),
+    "stripemode": (0x09, lambda a: bytes([["bin", "prog", "gray"].index(a[0])])),
+    "read": (0x0A, lambda a: b""),
+    "stats": (0x0B, lambda a: b""),
+}
+ARGUMENTS = {"rgb": 3, "read": 0, "stats": 0}
+REPLY_SIZES = {0x0A: 3, 0x0B: 6}
+
+STREAM_SOF = 0x5A
+SEGMENTS = [0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B, 0x77, 0x1F, 0x4E, 0x3D, 0x4F, 0x47]
+
+STATUS = ["ok", "checksum error", "unknown command", "command too long or reply full"]
+SWITCHES = ["none", "both", "S2", "S3"]
+
+
+def int16(text):
+    return (int(text, 0) & 0xFFFF).to_bytes(2, "little")
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(payload):
+    body = bytes([len(payload)]) + payload
+    return bytes([SOF]) + body + crc16(body).to_bytes(2, "big")
+
+
+def stream_frame(sequence, segments, negative, tens, stripe, red, green, blue):
+    """Streamed display frame, segments in abcdefg order with g as the LSB."""
+    body = bytes([sequence & 0xFF, segments, (1 if negative else 0) | (2 if tens else 0)])
+    body += (stripe & 0x3FF).to_bytes(2, "little") + bytes([red, green, blue])
+    return bytes([STREAM_SOF]) + body + crc16(body).to_bytes(2, "big")
+
+
+def wheel(position):
+    position %= 768
+    if position < 256:
+        return 255 - position, position, 0
+    if position < 512:
+        return 0, 511 - position, position - 256
+    return position - 512, 0, 767 - position
+
+
+def stream_test_pattern(fd, seconds, rate):
+    count = int(seconds * rate)
+    start = time.monotonic()
+    for i in range(count):
+        bounce = i % 18
+        stripe = 1 << (bounce if bounce < 10 else 18 - bounce)
+        os.write(fd, stream_frame(i, SEGMENTS[(i // 50) % 16], False, False, stripe, *wheel(i * 4)))
+        delay = start + (i + 1) / rate - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+    return count
+
+
+def build_payload(words):
+    payload = b""
+    i = 0
+    while i < len(words):
+        name = words[i]
+        if name not in COMMANDS:
+            raise ValueError(f"unknown command '{name}'")
+        count = ARGUMENTS.get(name, 1)
+        args = words[i + 1:i + 1 + count]
+        if len(args) < count:
+            raise ValueError(f"'{name}' needs {count} argument(s)")
+        command, encode = COMMANDS[name]
+        payload += bytes([command]) + encode(args)
+        i += 1 + count
+    if not payload or len(payload) > MAX_PAYLOAD:
+        raise ValueError(f"the commands must take 1 to {MAX_PAYLOAD} bytes")
+    return payload
+
+
+def payload_commands(payload):
+    """Yields the command ids of a payload built by build_payload()."""
+    sizes = {0x01: 2, 0x02: 1, 0x04: 2, 0x05: 3, 0x06: 1, 0x07: 2, 0x08: 1, 0x09: 1}
+    i = 0
+    while i < len(payload):
+        command = payload[i]
+        yield command
+        i += 1 + (1 + payload[i + 1] if command == 0x03 else sizes.get(command, 0))
+
+
+def read_frame(fd, timeout):
+    """Returns the payload of the next valid frame, or None after timeout seconds."""
+    deadline = time.monotonic() + timeout
+    buffer = b""
+    while True:
+        start = buffer.find(bytes([SOF]))
+        buffer = buffer[start:] if start >= 0 else b""
+        if len(buffer) >= 2 and len(buffer) >= buffer[1] + 4:
+            length = buffer[1]
+            body = buffer[1:2 + length]
+            if crc16(body) == int.from_bytes(buffer[2 + length:4 + length], "big"):
+                return body[1:]
+            buffer = buffer[1:]  # Not a frame start after all
+            continue
+        remaining = deadline - time.monotonic()
+        if remaining <= 0 or not select.select([fd], [], [], remaining)[0]:
+            return None
+        buffer += os.read(fd, 256)
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attributes = termios.tcgetattr(fd)
+    speed = getattr(termios, f"B{baud}")
+    attributes[4] = attributes[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attributes)
+    return fd
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Remote control of an HTL Uno over HTL_onboardProtocol")
+    parser.add_argument("port")
+    parser.add_argument("-b", "--baud", type=int, default=115200)
+    parser.add_argument("-w", "--wait", type=float, default=0, help="seconds to wait after opening the port")
+    parser.add_argument("-r", "--retries", type=int, default=3)
+    parser.add_argument("--stream", type=float, metavar="SECONDS", help="stream a test pattern of display frames")
+    parser.add_argument("--rate", type=float, default=200, help="streamed frames per second")
+    parser.add_argument("commands", nargs="*")
+    args = parser.parse_args()
+
+    if args.stream:
+        args.commands = ["stats"]
+    try:
+        payload = build_payload(args.commands)
+    except (ValueError, IndexError) as error:
+        parser.error(str(error))
+
+    fd = open_port(args.port, args.baud)
+    time.sleep(args.wait)
+    termios.tcflush(fd, termios.TCIFLUSH)
+
+    if args.stream:
+        print(f"sent {stream_test_pattern(fd, args.stream, args.rate)} frames")
+        time.sleep(0.1)
+
+    for _ in range(args.retries + 1):
+        os.write(fd, frame(payload))
+        reply = read_frame(fd, 1.0)
+        if reply is None or reply[0] == 1:
+            continue  # Lost or corrupted on the way, the board executed nothing
+        status, executed = reply[0], reply[1]
+        print(f"{STATUS[status] if status < len(STATUS) else status}, {executed} command(s) executed")
+        i = 2
+        for command in [c for c in payload_commands(payload)][:executed]:
+            if command == 0x0A:
+                pot = int.from_bytes(reply[i:i + 2], "little")
+                switch = reply[i + 2]
+                print(f"pot {pot} switches {SWITCHES[switch] if switch < len(SWITCHES) else switch}")
+            elif command == 0x0B:
+                streamed, dropped, late = (int.from_bytes(reply[i + j:i + j + 2], "little") for j in (0, 2, 4))
+                print(f"streamed {streamed} dropped {dropped} late {late}")
+            i += REPLY_SIZES.get(command, 0)
+        return 0 if status == 0 else 1
+
+    print("no answer", file=sys.stderr)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
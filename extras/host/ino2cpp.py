@@ -0,0 +1,28 @@
+# Converts an Arduino sketch (.ino) into a C++ translation unit for the host build.
+# Like the Arduino builder it includes Arduino.h and declares all functions up front.
+
+import re
+import sys
+
+FUNCTION = re.compile(r"^([A-Za-z_][\w:<>,\s\*&]*?[\s\*&])([A-Za-z_]\w*)\s*\(([^;{}]*)\)\s*\{", re.MULTILINE)
+KEYWORDS = {"if", "for", "while", "switch", "return", "else", "do"}
+
+def main():
+    path = sys.argv[1]
+    with open(path, "r", encoding="utf-8") as file:
+        source = file.read()
+
+    prototypes = []
+    for match in FUNCTION.finditer(source):
+        result, name, params = match.group(1).strip(), match.group(2), " ".join(match.group(3).split())
+        if name in KEYWORDS or result.split()[-1] in KEYWORDS:
+            continue
+        prototypes.append(f"{result} {name}({params});")
+
+    sys.stdout.write("#include <Arduino.h>\n")
+    sys.stdout.write("\n".join(prototypes) + "\n")
+    sys.stdout.write(f'#line 1 "{path}"\n')
+    sys.stdout.write(source)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,184 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Runs an Arduino sketch against the host board model.
+//
+// Usage: <sketch> [-t ms] [-p ms:value,...] [-s ms:state,...] [-a ms:value,...] [-v] [-d file] [-e file] [-S]
+//   -t  virtual run time in milliseconds (default 1000, with -S until interrupted)
+//   -p  potentiometer (A0) script, e.g. -p 0:0,500:1023
+//   -s  switch script with readSwitchState() states 0-3, e.g. -s 0:0,200:2,400:0
+//   -a  raw switch ladder (A1) script
+//   -v  trace every pin change of the display lines
+//   -d  write every change of the display lines as a VCD waveform to a file, see vcd_report.py
+//   -e  EEPROM image file, loaded before the run if it exists and saved after it
+//   -S  connect Serial to a new pseudo terminal and run in real time, so the sketch can be
+//       talked to like a board, e.g. with htl_remote.py. The terminal path goes to stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+void setup();
+void loop();
+
+static const uint32_t LOOP_OVERHEAD = 12; // main() loop of the core, serialEvent check
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Pseudo terminal for Serial; the slave end stays open in raw mode, so clients can come and go
+static bool openSerialTerminal() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return false;
+    }
+    const char* path = ptsname(master);
+    int slave = open(path, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    if (slave < 0 || tcgetattr(slave, &tio) < 0) {
+        perror(path);
+        return false;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    htl_host::attachSerial(master);
+    fprintf(stderr, "serial: %s\n", path);
+    return true;
+}
+
+static uint64_t wallMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool parseScript(const char* arg, uint8_t pin, bool states) {
+    const char* p = arg;
+    while (*p) {
+        char* end;
+        unsigned long ms = strtoul(p, &end, 10);
+        if (*end != ':') {
+            return false;
+        }
+        long value = strtol(end + 1, &end, 10);
+        htl_host::scriptAnalog(pin, ms, states ? htl_host::switchLevel((int)value) : (int)value);
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    unsigned long runMs = 1000;
+    bool runMsGiven = false;
+    bool realTime = false;
+    FILE* waveform = NULL;
+    const char* eepromImage = NULL;
+
+    htl_host::reset();
+
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (!strcmp(argv[i], "-v")) {
+            htl_host::setTrace(stdout);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            runMs = strtoul(argv[++i], NULL, 10);
+            runMsGiven = true;
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            ok = parseScript(argv[++i], A0, false);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            ok = parseScript(argv[++i], A1, true);
+        } else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            ok = parseScript(argv[++i], A1, false);
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            waveform = fopen(argv[++i], "w");
+            if (!waveform) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+            eepromImage = argv[++i];
+            htl_host::loadEEPROM(eepromImage);
+        } else if (!strcmp(argv[i], "-S")) {
+            realTime = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, "usage: %s [-t ms] [-p ms:value,...] [-s ms:state,...] [-a ms:value,...] [-v] [-d file] [-e file] [-S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (realTime) {
+        if (!openSerialTerminal()) {
+            return 1;
+        }
+        signal(SIGINT, requestStop);
+        signal(SIGTERM, requestStop);
+    }
+    bool forever = realTime && !runMsGiven;
+    uint64_t wallStart = wallMicros();
+
+    unsigned long loops = 0;
+    htl_host::recordVCD(waveform);
+    setup();
+    while ((forever || htl_host::cycles() < (uint64_t)runMs * (F_CPU / 1000)) && !stopRequested) {
+        loop();
+        htl_host::advance(LOOP_OVERHEAD);
+        loops++;
+
+        // Keep the virtual clock from running ahead of the wall clock
+        if (realTime && (loops & 0x3F) == 0) {
+            uint64_t virtualMicros = htl_host::cycles() / (F_CPU / 1000000);
+            uint64_t elapsed = wallMicros() - wallStart;
+            if (virtualMicros > elapsed + 1000) {
+                usleep(virtualMicros - elapsed);
+            }
+        }
+    }
+
+    if (waveform) {
+        htl_host::recordVCD(NULL);
+        fclose(waveform);
+    }
+
+    if (eepromImage && !htl_host::saveEEPROM(eepromImage)) {
+        perror(eepromImage);
+        return 1;
+    }
+
+    fflush(stdout);
+    printf("\nloop calls  %lu\n", loops);
+    htl_host::report(stdout);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Probe of the streamed, dropped and late frame counts of HTL_onboardProtocol: frames shown
+// in time, after a setter, replaced before their slot, missing from the sequence, noticed late
+// by update() and held back by a batch.
+
+#include <stdio.h>
+#include <deque>
+
+#include "Arduino.h"
+#include "HTL_onboard.h"
+
+// Serial line of the probe, filled with whole frames
+class Line : public Stream {
+public:
+    std::deque<uint8_t> received;
+
+    int available() { return received.size(); }
+    int read() {
+        if (received.empty()) {
+            return -1;
+        }
+        int c = received.front();
+        received.pop_front();
+        return c;
+    }
+    int peek() { return received.empty() ? -1 : received.front(); }
+    size_t write(uint8_t) { return 1; }
+    using Print::write;
+};
+
+static HTL_onboard onboard;
+static Line line;
+static HTL_onboardProtocol protocol(onboard, line);
+
+static uint16_t crc16(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// A streamed display frame with the sequence number and LED stripe bits, passed to update()
+static void stream(uint8_t sequence, uint16_t stripe) {
+    const uint8_t payload[8] = {sequence, 0x30, 0x01, (uint8_t)stripe, (uint8_t)(stripe >> 8), 255, 0, 0};
+    uint16_t crc = 0xFFFF;
+    line.received.push_back(0x5A);
+    for (int i = 0; i < 8; i++) {
+        line.received.push_back(payload[i]);
+        crc = crc16(crc, payload[i]);
+    }
+    line.received.push_back(crc >> 8);
+    line.received.push_back(crc & 0xFF);
+    protocol.update();
+}
+
+// Polls the multiplexer for 2.5 ms, long enough for a slot with its bit-angle modulated steps
+static void slot() {
+    for (int i = 0; i < 25; i++) {
+        htl_host::advance(F_CPU / 10000);
+        onboard.updateMultiplex();
+    }
+}
+
+static void print(const char* step) {
+    unsigned long shownTime;
+    bool pending = onboard.rawFramePending(shownTime);
+    printf("%-9s streamed %u dropped %u late %u pending %d\n", step, protocol.getStreamedFrames(),
+           protocol.getDroppedFrames(), protocol.getLateFrames(), pending);
+}
+
+int main() {
+    htl_host::reset();
+    onboard.begin();
+    const int modes[3] = {MODE_HEX, MODE_STRIPE, MODE_RGB};
+    onboard.setModesMultiplex(modes, 3);
+    for (int i = 0; i < 5; i++) {
+        slot();
+    }
+
+    stream(0, 0x001);
+    slot();
+    print("shown");
+
+    // A setter after the shown frame does not make the next frame a drop
+    onboard.setHexNumber(3);
+    stream(1, 0x002);
+    print("setter");
+    slot();
+
+    stream(2, 0x004);
+    stream(3, 0x008);
+    print("replaced");
+    slot();
+
+    stream(6, 0x010);
+    slot();
+    print("gap");
+
+    // Shown in the next slot, update() only notices it 20 ms later
+    stream(7, 0x020);
+    slot();
+    delay(20);
+    protocol.update();
+    print("noticed");
+
+    // Held back 20 ms by a batch
+    onboard.beginFrame();
+    stream(8, 0x040);
+    delay(20);
+    onboard.commitFrame();
+    slot();
+    protocol.update();
+    print("held");
+    return 0;
+}
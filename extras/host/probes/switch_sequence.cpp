@@ -0,0 +1,59 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Probe of the switch events of the ADC sampler: a scripted sequence of presses, a bounce
+// shorter than SWITCH_DEBOUNCE_MS, both switches and a long press, printed in queue order.
+
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "HTL_onboard.h"
+
+static const char* const EVENT_NAMES[5] = {"none", "press", "release", "long", "both"};
+
+int main() {
+    htl_host::reset();
+
+    // (ms, state) steps of the switch ladder, states as in readSwitchState()
+    const unsigned long steps[][2] = {
+        {100, 2}, {200, 0}, // S2 pressed for 100 ms
+        {300, 3}, {305, 0}, // S3 bounce, shorter than the debounce time
+        {400, 3}, {500, 0}, // S3 pressed for 100 ms
+        {600, 2}, {650, 1}, {750, 3}, {800, 0}, // S2, then both, S3 released last
+        {900, 2}, {2200, 0}, // S2 held past SWITCH_LONG_PRESS_MS
+    };
+    for (unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        htl_host::scriptAnalog(A1, steps[i][0], htl_host::switchLevel((int)steps[i][1]));
+    }
+
+    HTL_onboard onboard;
+    onboard.begin();
+    onboard.beginAnalogSampler();
+
+    // Polled every 10 ms, the queue keeps the order and the detection time
+    while (millis() < 2500) {
+        delay(10);
+        SwitchEvent event;
+        while (onboard.getSwitchEvent(event)) {
+            printf("%5lu ms %-7s S2=%d S3=%d\n", event.time, EVENT_NAMES[event.type],
+                   (event.switches & SWITCH_S2) != 0, (event.switches & SWITCH_S3) != 0);
+        }
+    }
+    printf("lost %u\n", (unsigned)onboard.getLostSwitchEvents());
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+   Copyright 2024 Tobias Weich
+*/
+
+/*
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+// Probe of beginFrame()/commitFrame(): loop() alternates the stripe mode and value at 20000
+// slots per second, once with and once without a batch. A stripe slot that shows neither
+// state is torn, e.g. the new mode with the old value cut to its range.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+#include "Arduino.h"
+#include "HTL_onboard.h"
+
+static const char* const STATE_BEGIN = "0000000000"; // The frame of begin()
+static const char* const STATE_PROG = "0000000111"; // STRIPE_MODE_PROG with 3
+static const char* const STATE_BIN = "1111110000"; // STRIPE_MODE_BIN with 0x3F0
+static const double SETTLED_MS = 0.025; // Shorter patterns are transients of a slot being written
+
+static void run(bool batch) {
+    char* trace = NULL;
+    size_t traceSize = 0;
+    FILE* out = open_memstream(&trace, &traceSize);
+
+    htl_host::reset();
+    HTL_onboard onboard;
+    onboard.begin();
+    const int modes[1] = {MODE_STRIPE};
+    onboard.setModesMultiplex(modes, 1);
+    onboard.beginTimerMultiplex(20000);
+
+    htl_host::setTrace(out);
+    for (int i = 0; i < 2000; i++) {
+        if (batch) {
+            onboard.beginFrame();
+        }
+        if (i & 1) {
+            onboard.setStripeMode(STRIPE_MODE_PROG);
+            delayMicroseconds(60); // Other work of loop() between the two calls
+            onboard.setLedStripeValue(3);
+        } else {
+            onboard.setStripeMode(STRIPE_MODE_BIN);
+            delayMicroseconds(60);
+            onboard.setLedStripeValue(0x3F0);
+        }
+        if (batch) {
+            onboard.commitFrame();
+        }
+        delay(2);
+    }
+    htl_host::setTrace(NULL);
+    onboard.endTimerMultiplex();
+    fclose(out);
+
+    // Stripe windows that were held long enough to be seen, by their data lines
+    std::map<std::string, unsigned long> windows;
+    double since = -1;
+    std::string pattern;
+    bool stripe = false;
+    for (char* line = strtok(trace, "\n"); line; line = strtok(NULL, "\n")) {
+        double time = atof(line);
+        const char* sel = strstr(line, "sel=");
+        const char* data = strstr(line, "data=");
+        if (!sel || !data) {
+            continue;
+        }
+        std::string next(data + 5, 10);
+        bool nextStripe = sel[5] == 'S';
+        if (nextStripe == stripe && next == pattern) {
+            continue;
+        }
+        if (stripe && since >= 0 && time - since >= SETTLED_MS) {
+            windows[pattern]++;
+        }
+        since = time;
+        pattern = next;
+        stripe = nextStripe;
+    }
+    free(trace);
+
+    unsigned long total = 0;
+    unsigned long torn = 0;
+    for (std::map<std::string, unsigned long>::const_iterator it = windows.begin(); it != windows.end(); ++it) {
+        total += it->second;
+        if (it->first != STATE_BEGIN && it->first != STATE_PROG && it->first != STATE_BIN) {
+            torn += it->second;
+        }
+    }
+    printf("%s: stripe slots %lu torn %lu\n", batch ? "batch" : "no batch", total, torn);
+    for (std::map<std::string, unsigned long>::const_iterator it = windows.begin(); it != windows.end(); ++it) {
+        printf("  %s %lu\n", it->first.c_str(), it->second);
+    }
+}
+
+int main() {
+    run(false);
+    run(true);
+    return 0;
+}
@@ -0,0 +1,197 @@
+# Breaks down the flash and SRAM use of the HTL_onboard library by feature.
+#
+# Usage: size_report.py [--objdump TOOL] [--readelf TOOL] [--target NAME] objects...
+#
+# The symbols of the objects (objdump -t) give code, tables and static data. The members of
+# one HTL_onboard instance come from the debug info (readelf), so the objects need -g. As on
+# the AVR, .rodata and .data count towards flash and SRAM, .progmem only towards flash and
+# .bss only towards SRAM. Every symbol and member is assigned to the first matching feature.
+# For host objects the avr column estimates each member on the ATmega328P from its type:
+# int and pointers have 2 bytes, long and float 4, and nothing is padded.
+
+import argparse
+import re
+import subprocess
+import sys
+
+FEATURES = [
+    ("Serial protocol", r"^HTL_onboardProtocol::|^commandSizes$"),
+    ("Multiplex stats", r"[Ss]tats|^record(Slot|LoopGap)$|^timerSlotMicros$"),
+    ("Glyph tables", r"^(charMap|segmentMap|charSegments|hexLines)$"),
+    ("Pin maps", r"^(pinMapping|pinMappingStripe|selectPins)$"),
+    ("Potentiometer filter", r"[Pp]ot"),
+    ("Switch calibration", r"[Cc]alibrat|SwitchLevel"),
+    ("Switch events", r"SwitchEvent|switchEvents|^event|lostSwitchEvents|debounceSwitches|^switchCandidate$|"
+                      r"^candidateSince$|^switchStable$|^stableSince$|^longPressSent$|^getSwitches$|^stateSwitches$"),
+    ("Switches", r"[Ss]witch"),
+    ("Analog sampler", r"^adc|[Ss]ample|^rateWindow|ADC_vect"),
+    ("Paged numbers", r"[Pp]age"),
+    ("String display", r"^str([A-Z].*)?$|String"),
+    ("Gray stripe", r"[Ss]tripeLevel|^stripeDither$|^outputStripeSlot$"),
+    ("RGB and bit-angle modulation", r"(?i)rgb|bam|^(set|get)?(red|green|blue)$|^pwmActive$|^releasePWM$"),
+    ("Tasks", r"[Tt]ask|^wheel"),
+    ("Animations", r"[Aa]nimation"),
+    ("Idle sleep", r"^idle$|[Ss]leep|[Ww]ake|PCINT"),
+    ("Timer multiplex", r"[Tt]imer|TIMER2"),
+    ("Weights and brightness", r"[Ww]eight|slotsLeft|[Bb]rightness|^slotStartMicros$|^slotDimmed$|^multiplexBlank$"),
+    ("Port output", r"[Ff]astOutput|Ports$|^portCount$|^outPorts$|Mask$|^select(Port|Bit)$|LineBits$|^ioWrites$|"
+                    r"^pin(Write|Output)$|FrameWrites$|WritesPerFrame$"),
+    ("Frame cache", r"[Ff]rame"),
+    ("Multiplex", r"[Mm]ultiplex|^currentMode$|^modesActive$|^setMode$|^blankDisplays$|^writeLines$"),
+    ("HEX display", r"[Hh]ex|HEX|^writeInt$|^(write|set)Char$"),
+    ("LED stripe", r"[Ss]tripe|^writeBinary$|^writeProgress$|LED$"),
+    ("Core", r""),
+]
+
+SYMBOL = re.compile(r"^([0-9a-f]+)\s(.{7})\s(\S+)\s+([0-9a-f]+)\s+(.*)$")
+
+
+def feature_of(name):
+    for feature, pattern in FEATURES:
+        if re.search(pattern, name):
+            return feature
+    return "Core"
+
+
+def bare_name(symbol):
+    # "HTL_onboard::setRGB(unsigned char, ...) [clone .part.0]" -> "setRGB"
+    # Members of the helper classes keep their class: "HTL_onboardProtocol::update"
+    symbol = re.sub(r"\(.*$", "", symbol).strip()
+    parts = symbol.split("::")
+    if len(parts) > 1 and parts[-2] != "HTL_onboard":
+        return parts[-2] + "::" + parts[-1]
+    return parts[-1]
+
+
+def symbol_sizes(objdump, objects):
+    """Yields (name, section, size) of every defined function and object, aliases once."""
+    seen = set()
+    for obj in objects:
+        out = subprocess.run([objdump, "-t", "-C", obj], check=True, capture_output=True, text=True).stdout
+        for line in out.splitlines():
+            match = SYMBOL.match(line)
+            if not match:
+                continue
+            address, flags, section, size, name = match.groups()
+            size = int(size, 16)
+            if size == 0 or ("F" not in flags and "O" not in flags) or section.startswith(".debug"):
+                continue
+            key = (obj, section, address)
+            if key in seen:
+                continue  # Constructor and destructor variants share one body
+            seen.add(key)
+            yield bare_name(name), section, size
+
+
+AVR_BASE_SIZES = {"int": 2, "unsigned int": 2, "short int": 2, "short unsigned int": 2,
+                  "long int": 4, "long unsigned int": 4, "float": 4, "double": 4}
+
+
+def avr_size(entries, index, offset):
+    """Estimates the size of the type at a debug info offset with the AVR type sizes."""
+    depth, tag, attributes = entries[index[offset]]
+    if tag in ("DW_TAG_pointer_type", "DW_TAG_reference_type", "DW_TAG_enumeration_type"):
+        return 2
+    if tag == "DW_TAG_base_type":
+        return AVR_BASE_SIZES.get(attributes.get("DW_AT_name"), int(attributes.get("DW_AT_byte_size", "0"), 0))
+    if tag in ("DW_TAG_typedef", "DW_TAG_volatile_type", "DW_TAG_const_type"):
+        return avr_size(entries, index, attributes["DW_AT_type"])
+    children = []
+    for child_depth, child_tag, child in entries[index[offset] + 1:]:
+        if child_depth <= depth:
+            break
+        if child_depth == depth + 1:
+            children.append((child_tag, child))
+    if tag == "DW_TAG_array_type":
+        count = 1
+        for child_tag, child in children:
+            if child_tag == "DW_TAG_subrange_type":
+                count *= int(child.get("DW_AT_count", str(int(child.get("DW_AT_upper_bound", "-1"), 0) + 1)), 0)
+        return count * avr_size(entries, index, attributes["DW_AT_type"])
+    # Structures: the non-static members and base classes, without padding
+    return sum(avr_size(entries, index, child["DW_AT_type"]) for child_tag, child in children
+               if child_tag in ("DW_TAG_member", "DW_TAG_inheritance") and "DW_AT_data_member_location" in child)
+
+
+def instance_members(readelf, objects):
+    """Returns [(member, size, avr)] of the HTL_onboard class from the first object describing it."""
+    for obj in objects:
+        out = subprocess.run([readelf, "--debug-dump=info", obj], check=True, capture_output=True, text=True).stdout
+        entries = []  # (depth, tag, attributes)
+        index = {}  # "<0x...>" reference of an entry -> its position in entries
+        for line in out.splitlines():
+            tag = re.match(r"\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: \d+ \((\w+)\)", line)
+            if tag:
+                index[f"<0x{tag.group(2)}>"] = len(entries)
+                entries.append((int(tag.group(1)), tag.group(3), {}))
+                continue
+            attribute = re.match(r"\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*:\s*(.*)$", line)
+            if attribute and entries:
+                entries[-1][2][attribute.group(1)] = attribute.group(2).split(": ")[-1].strip()
+
+        for i, (depth, tag, attributes) in enumerate(entries):
+            if tag not in ("DW_TAG_class_type", "DW_TAG_structure_type"):
+                continue
+            if attributes.get("DW_AT_name") != "HTL_onboard" or "DW_AT_byte_size" not in attributes:
+                continue
+            size = int(attributes["DW_AT_byte_size"], 0)
+            offsets = []
+            for child_depth, child_tag, child in entries[i + 1:]:
+                if child_depth <= depth:
+                    break
+                if child_depth == depth + 1 and child_tag == "DW_TAG_member" and "DW_AT_data_member_location" in child:
+                    offsets.append((int(child["DW_AT_data_member_location"], 0), child.get("DW_AT_name", "?"),
+                                    avr_size(entries, index, child["DW_AT_type"])))
+            offsets.sort()
+            # Padding up to the next member is counted with the member before it
+            return [(name, (offsets[j + 1][0] if j + 1 < len(offsets) else size) - offset, avr)
+                    for j, (offset, name, avr) in enumerate(offsets)]
+    return []
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--objdump", default="objdump")
+    parser.add_argument("--readelf", default="readelf")
+    parser.add_argument("--target", default="host")
+    parser.add_argument("objects", nargs="+")
+    args = parser.parse_args()
+
+    names = [feature for feature, _ in FEATURES]
+    flash = dict.fromkeys(names, 0)
+    sram = dict.fromkeys(names, 0)
+    instance = dict.fromkeys(names, 0)
+    avr = dict.fromkeys(names, 0)
+    host = not args.target.startswith("atmega")
+
+    for name, section, size in symbol_sizes(args.objdump, args.objects):
+        feature = feature_of(name)
+        if section.startswith((".text", ".progmem", ".rodata", ".data")):
+            flash[feature] += size
+        if section.startswith((".rodata", ".data", ".bss")):
+            sram[feature] += size
+
+    for name, size, avr_estimate in instance_members(args.readelf, args.objects):
+        instance[feature_of(name)] += size
+        avr[feature_of(name)] += avr_estimate
+
+    def row(label, values):
+        print(f"{label:<30}{values[0]:>8}{values[1]:>8}{values[2]:>10}" + (f"{values[3]:>8}" if host else ""))
+
+    print(f"HTL_onboard size by feature ({args.target})")
+    print(f"{'feature':<30}{'flash':>8}{'sram':>8}{'instance':>10}" + (f"{'avr':>8}" if host else ""))
+    for feature in names:
+        if flash[feature] or sram[feature] or instance[feature]:
+            row(feature, (flash[feature], sram[feature], instance[feature], avr[feature]))
+    row("total", (sum(flash.values()), sum(sram.values()), sum(instance.values()), sum(avr.values())))
+    print("flash: code, tables and initial data; sram: static data; instance: SRAM of each HTL_onboard object"
+          + ("; avr: the same estimated for the ATmega328P" if host else ""))
+    if host:
+        print(f"sizeof(HTL_onboard): {sum(instance.values())} bytes on the host, about {sum(avr.values())} bytes on the AVR")
+    else:
+        print(f"sizeof(HTL_onboard): {sum(instance.values())} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+# Timing analysis of the display lines in a VCD waveform, e.g. written by the host runner with -d.
+#
+# Usage: vcd_report.py FILE [--from MS] [--to MS] [--list N]
+#
+# Reports for each display the share of time its select line was active and the number and
+# length of its windows, the time two or more displays were selected at once (overlap) and the
+# blank time with no display selected. A data line that switches on (low) while the HEX
+# display or the LED stripe stays selected lights a segment of the next pattern on the current
+# display (ghosting); --list prints the first N of them. Lines that switch off while the display
+# stays selected only blank it early and are counted separately as blanked. Changes of the RGB
+# pins while the RGB LED is selected are counted as bit-angle modulation steps; the steps of a
+# stripe in STRIPE_MODE_GRAY look like ghosting and are counted as such. A port store or pinMode() that changed no line is a redundant
+# write.
+#
+# The waveform needs wires named D0 to D12 (select lines D10 HEX, D11 stripe and D12 RGB,
+# active low), so logic analyzer captures with these channel names can be analyzed as well.
+# Redundant writes need the "write" event of the host model.
+
+import argparse
+import re
+import sys
+
+DISPLAYS = ["HEX", "STRIPE", "RGB"]
+SELECT_LINES = [10, 11, 12]
+RGB_LINES = {5, 6, 9}
+UNITS = {"s": 1.0, "ms": 1e-3, "us": 1e-6, "ns": 1e-9, "ps": 1e-12, "fs": 1e-15}
+
+
+class Window:
+    def __init__(self):
+        self.count = 0
+        self.total = 0
+        self.shortest = None
+        self.longest = 0
+        self.since = None  # Start of the open window
+
+    def close(self, time):
+        length = time - self.since
+        self.count += 1
+        self.total += length
+        self.shortest = length if self.shortest is None else min(self.shortest, length)
+        self.longest = max(self.longest, length)
+        self.since = None
+
+
+def parse(path):
+    """Returns the time unit in seconds, the lines by id, the write event id and the changes."""
+    tokens = open(path).read().split()
+    unit = 1e-9
+    lines = {}
+    write_id = None
+    changes = []  # (time, id, value)
+    time = 0
+    i = 0
+    while i < len(tokens):
+        token = tokens[i]
+        if token == "$timescale":
+            end = tokens.index("$end", i)
+            match = re.match(r"(\d+)\s*(\w+)", "".join(tokens[i + 1:end]))
+            unit = int(match.group(1)) * UNITS[match.group(2)]
+            i = end
+        elif token == "$var":
+            end = tokens.index("$end", i)
+            kind, ident, name = tokens[i + 1], tokens[i + 3], tokens[i + 4]
+            match = re.match(r"D(\d+)(_\w+)?$", name)
+            if kind == "wire" and match and int(match.group(1)) <= 12:
+                lines[ident] = int(match.group(1))
+            elif kind == "event" and name == "write":
+                write_id = ident
+            i = end
+        elif token.startswith("$"):
+            if token not in ("$dumpvars", "$end", "$dumpall", "$dumpon", "$dumpoff"):
+                i = tokens.index("$end", i)
+        elif token.startswith("#"):
+            time = int(token[1:])
+            changes.append((time, None, None))
+        elif token[0] in "rRbB":
+            i += 1  # Real and vector values are followed by their id, not needed here
+        else:
+            changes.append((time, token[1:], token[0].lower()))
+        i += 1
+    return unit, lines, write_id, changes
+
+
+def analyze(unit, lines, write_id, changes, start, stop, listed):
+    level = {line: "z" for line in range(13)}
+    windows = [Window() for _ in DISPLAYS]
+    ghosting = [0, 0, 0]
+    blanked = [0, 0, 0]
+    ghost_list = []
+    overlap_time = overlap_count = 0
+    blank_time = longest_blank = 0
+    blank_since = None
+    writes = redundant = 0
+    first = last = None
+
+    def selected(state):
+        return [d for d in range(3) if state[SELECT_LINES[d]] == "0"]
+
+    # Group the changes of one time stamp, they happen at once
+    index = 0
+    previous = None
+    while index < len(changes):
+        time = changes[index][0]
+        changed = set()
+        wrote = False
+        while index < len(changes) and changes[index][0] == time:
+            _, ident, value = changes[index]
+            if ident in lines and level[lines[ident]] != value:
+                level[lines[ident]] = value
+                changed.add(lines[ident])
+            elif ident is not None and ident == write_id:
+                wrote = True
+            index += 1
+
+        before = selected(previous) if previous else []
+        after = selected(level)
+        previous = dict(level)
+        if time < start:
+            continue
+        if time > stop:
+            break
+        if first is None:
+            first = time
+            for d in after:
+                windows[d].since = time
+            if not after:
+                blank_since = time
+        else:
+            elapsed = time - last
+            if len(before) > 1:
+                overlap_time += elapsed
+        last = time
+
+        # Window edges of the select lines
+        for d in range(3):
+            if d in before and d not in after and windows[d].since is not None:
+                windows[d].close(time)
+            elif d in after and d not in before:
+                windows[d].since = time
+        if len(after) > 1 and len(before) <= 1:
+            overlap_count += 1
+        if not after and before:
+            blank_since = time
+        elif after and not before and blank_since is not None:
+            blank_time += time - blank_since
+            longest_blank = max(longest_blank, time - blank_since)
+            blank_since = None
+
+        # Data changes while a display stays selected, only lines switching on (active low) ghost
+        data = {line for line in changed if line < 10}
+        for d in set(before) & set(after):
+            if d == 2:
+                if data & RGB_LINES:
+                    ghosting[d] += 1
+                continue
+            lit = sorted(line for line in data if level[line] == "0")
+            if lit:
+                ghosting[d] += 1
+                if len(ghost_list) < listed:
+                    ghost_list.append((time, d, lit))
+            elif data:
+                blanked[d] += 1
+
+        if wrote:
+            writes += 1
+            if not changed:
+                redundant += 1
+
+    if first is None:
+        print("no changes in the selected time range", file=sys.stderr)
+        return 1
+    for d in range(3):
+        if windows[d].since is not None:
+            windows[d].close(last)
+    if blank_since is not None:
+        blank_time += last - blank_since
+        longest_blank = max(longest_blank, last - blank_since)
+
+    total = last - first
+    us = unit * 1e6
+
+    def share(part):
+        return 100.0 * part / total if total else 0.0
+
+    print(f"time        {total * unit * 1e3:.3f} ms from {first * unit * 1e3:.3f} ms")
+    for d in range(3):
+        w = windows[d]
+        line = f"{DISPLAYS[d]:<8}    on {share(w.total):5.1f}%  windows={w.count}"
+        if w.count:
+            line += f"  min={w.shortest * us:.1f} avg={w.total / w.count * us:.1f} max={w.longest * us:.1f} us"
+        if d == 2:
+            line += f"  steps={ghosting[d]}"
+        else:
+            line += f"  ghosting={ghosting[d]} blanked={blanked[d]}"
+        print(line)
+    print(f"overlap     {share(overlap_time):5.1f}%  windows={overlap_count}")
+    print(f"blank       {share(blank_time):5.1f}%  longest={longest_blank * us:.1f} us")
+    if write_id is not None:
+        slots = sum(w.count for w in windows)
+        print(f"writes      {writes}  redundant={redundant} ({100.0 * redundant / writes if writes else 0.0:.1f}%)"
+              f"  per window={writes / slots if slots else 0.0:.1f}")
+    for time, d, changed in ghost_list:
+        print(f"ghosting    {time * unit * 1e3:10.3f} ms  {DISPLAYS[d]:<6}  " + " ".join(f"D{line}" for line in changed))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Timing analysis of the display lines in a VCD waveform")
+    parser.add_argument("file")
+    parser.add_argument("--from", dest="start", type=float, default=0, metavar="MS", help="start of the analysis")
+    parser.add_argument("--to", dest="stop", type=float, metavar="MS", help="end of the analysis")
+    parser.add_argument("--list", type=int, default=5, metavar="N", help="ghosting changes to list")
+    args = parser.parse_args()
+
+    unit, lines, write_id, changes = parse(args.file)
+    if not any(line in SELECT_LINES for line in lines.values()):
+        print(f"{args.file}: no select lines D10 to D12", file=sys.stderr)
+        return 1
+    start = args.start * 1e-3 / unit
+    stop = args.stop * 1e-3 / unit if args.stop is not None else float("inf")
+    return analyze(unit, lines, write_id, changes, start, stop, args.list)
+
+
+if __name__ == "__main__":
+    sys.exit(main())